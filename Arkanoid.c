@@ -4,20 +4,215 @@
 
 ********************************************************************************************/
 
+#ifdef ARKANOID_CORE
+    // Simulation only (see "Simulation core" in the README): no raylib, no libc, no heap.
+    // Built with -ffreestanding -nostdlib; as GCC requires of any freestanding target, the
+    // platform supplies memcpy/memset, and without an FPU the compiler's soft-float routines
+    // (libgcc) do the float arithmetic. Nothing from libm is used: __builtin_sqrtf would still
+    // call sqrtf unless built with -fno-math-errno, and always does without an FPU, so square
+    // roots come from core_sqrtf() below
+    #include <stdint.h>
+    #include <stdbool.h>
+    #include <stddef.h>
+    typedef struct Vector2 { float x, y; } Vector2;
+    typedef struct Rectangle { float x, y, width, height; } Rectangle;
+    typedef struct Color { unsigned char r, g, b, a; } Color;
+    #define GRAY       (Color){ 130, 130, 130, 255 }
+    #define ORANGE     (Color){ 255, 161, 0, 255 }
+    #define memcpy     __builtin_memcpy
+    #define memset     __builtin_memset
+    #define sqrtf      core_sqrtf
+    #define fabsf      __builtin_fabsf
+    #define fminf(a, b) ((a) < (b) ? (a) : (b))   // No NaNs reach these, so no libm needed
+    #define fmaxf(a, b) ((a) > (b) ? (a) : (b))
+    #define floorf     __builtin_floorf
+    #define INFINITY   __builtin_inff()
+
+    static inline float core_sqrtf(float x)
+    {
+        // IEEE square root in integer arithmetic, bit for bit what sqrtf() gives (round to nearest),
+        // so a core build plays exactly like the full game: one result bit per step, then the
+        // remainder decides the rounding. Same method as fdlibm's e_sqrtf.c
+        uint32_t bits;
+        memcpy(&bits, &x, 4);
+        if ((bits & 0x7fffffffu) == 0 || (bits & 0x7fffffffu) > 0x7f800000u || bits == 0x7f800000u) return x;  // +-0, NaN, +inf
+        if (bits >> 31) return __builtin_nanf("");                             // Negative
+        int32_t e = (int32_t)(bits >> 23);
+        uint32_t m = bits & 0x007fffffu;
+        if (e == 0)                                                             // Subnormal: normalise
+        {
+            while ((m & 0x00800000u) == 0) { m <<= 1; e--; }
+            e++;
+        }
+        m |= 0x00800000u;
+        e -= 127;
+        if (e & 1) m += m;                                                      // Even exponent, halved below
+        e = (e - (e & 1))/2;
+
+        m += m;
+        uint32_t q = 0, s = 0;
+        for (uint32_t r = 0x01000000u; r != 0; r >>= 1)
+        {
+            uint32_t t = s + r;
+            if (t <= m) { s = t + r; m -= t; q += r; }
+            m += m;
+        }
+        if (m != 0) q += q & 1;                                                 // Inexact: round half to even
+        bits = (q >> 1) + 0x3f000000u + ((uint32_t)e << 23);
+        memcpy(&x, &bits, 4);
+        return x;
+    }
+#else
+#if !defined(_WIN32) && !defined(_GNU_SOURCE)
+    #define _GNU_SOURCE                  // dladdr() and signal context registers for the profiler
+#endif
 #include "raylib.h"                  // Loads raylib library for graphics, windows, and input
+#include "rlgl.h"                    // Matrix stack, to draw scaled-down game tiles in one batch
+#ifdef _WIN32                        // glFinish() from the system GL library raylib links, for the bench
+    __declspec(dllimport) void __stdcall glFinish(void);
+#else
+    void glFinish(void);
+#endif
 #include <stdio.h>                   // Standard I/O library for debugging (optional here)
 #include <stdlib.h>                  // Standard library for things like random numbers
+#include <stdint.h>                  // Fixed-width integers for bitmasks
+#include <string.h>                  // memcpy/strcmp
 #include <math.h>                    // Math functions, used mostly for collision/math ops
 #include <time.h>                    // Needed for random seed initialization
+#include <stdarg.h>                  // log_msg() arguments
+#ifndef _WIN32
+    #include <unistd.h>                  // fork()/sysconf() for the replay converter's worker processes
+    #include <sys/wait.h>
+    #include <sys/socket.h>              // Unix socket the metrics thread serves
+    #include <sys/un.h>
+    #include <sys/time.h>
+    #include <pthread.h>
+    #include <semaphore.h>               // Wakes the flight recorder's dump thread without a lock
+    #include <signal.h>                  // SIGPROF sampling profiler
+    #include <ucontext.h>
+    #include <dlfcn.h>                   // dladdr() to name the profiler's addresses
+    #include <sys/mman.h>                // Attract mode maps replays instead of reading them
+    #include <sys/stat.h>
+    #include <fcntl.h>
+#endif
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    #include <immintrin.h>               // AVX2/FMA autopilot layers, used when the CPU has them
+    #define MLP_AVX2
+#endif
+#endif // ARKANOID_CORE
 
 //----------------------------------------------------------------------------------
 // Defines - #define macros for tuneable numbers, easy tweaking
 //----------------------------------------------------------------------------------
 #define PLAYER_MAX_LIFE    3         // Maximum number of lives player starts with
-#define LINES_OF_BRICKS    5         // Number of rows of bricks in the game area
-#define BRICKS_PER_LINE    10        // Number of bricks per row
+#define LINES_OF_BRICKS    5         // Number of rows of bricks in the default level
+#define BRICKS_PER_LINE    10        // Number of bricks per row in the default level
+#ifdef ARKANOID_CORE
+#define BRICKS_MAX         64        // Core build: the default grid only (a multiple of 64)
+#define BRICK_POLYS_MAX    1         // ...so no polygonal bricks
+#define CORE_STATE_BUDGET  (12*1024) // Bytes all of the core's state may take, checked when compiling
+#else
+#define BRICKS_MAX         (1 << 24) // Most bricks a level file may hold; memory is only taken for the ones it has
+#endif
+#define BRICK_WORDS        (BRICKS_MAX/64) // 64-bit words in the brick alive mask
+#define BRICK_POLY_VERTS   8         // Most corners a polygonal brick may have
+#define BRICK_BATCH        16        // Rectangle candidates the narrow phase tests in one go
+#define BVH_NODES_MAX      (2*BRICKS_MAX) // A binary tree over N bricks never needs more nodes
+#define BVH_LEAF_BRICKS    4         // Bricks per BVH leaf
+#define BVH_SAH_BINS       16        // Candidate split planes per axis when building
+#define BVH_SAH_DEPTH      48        // Below this depth fall back to halving, keeps the tree shallow
+#define BVH_STACK_SIZE     128       // Traversal stack (tree depth stays under BVH_SAH_DEPTH + 20)
 #define BALLS_MAX          5         // Maximum number of balls that can exist at a time
 #define POWERUPS_MAX       10        // Maximum number of falling powerup objects
+#define BALL_CONTACTS_MAX  4         // Most bricks one ball can overlap in a single tick
+
+#define TARGET_FPS         60        // Frames drawn per second
+#define TICK_RATE          60        // Fixed simulation steps per second (speeds below are per tick)
+#define TICK_DT            (1.0/TICK_RATE) // Length of one simulation step in seconds
+#define MAX_TICKS_PER_FRAME 5        // Catch-up limit so a long stall can't spiral
+#define INPUT_POLL_HZ      1000      // How often keys are sampled while waiting for the next frame
+#define INPUT_QUEUE_SIZE   64        // Timestamped input events buffered between ticks (power of two)
+
+#define AUDIO_SAMPLE_RATE  44100     // Mixer output rate (mono, 32-bit float)
+#define AUDIO_BUFFER_FRAMES 512      // Device buffer size, ~12 ms of latency
+#define AUDIO_VOICES       16        // Sounds that can play at once; extra ones steal the oldest
+#define AUDIO_QUEUE_SIZE   64        // Play requests in flight to the mixer (power of two)
+#define SOUND_MAX_FRAMES   (AUDIO_SAMPLE_RATE/2) // Longest sound effect, half a second
+
+#define REPLAY_VERSION     1         // Bump when the replay file layout or game rules change
+#define REPLAY_MAX_TICKS   (TICK_RATE*60*60) // One hour of play per replay
+#define REPLAY_LEVEL_CHARS 240       // Room for the level path in a replay header
+#define DATASET_SHARD_MB   256       // Default size of one converter output file
+#define DATASET_SHARD_MB_MAX 2047    // Largest --shard-mb: shard offsets go through ftell(), a 32-bit long on Windows
+
+#define MLP_MAX_LAYERS     4         // Fully-connected layers in an autopilot network
+#define MLP_MAX_WIDTH      128       // Widest layer (inputs and outputs, after padding)
+#define MLP_MAX_BATCH      64        // Games evaluated per mlp_forward() call
+#define MLP_LANES          8         // Layer widths are padded to this many floats (one AVX register)
+#define MLP_ROWS           4         // Batch rows mlp_layer() accumulates at once, in registers (a0..a3)
+
+#define SCRIPT_CODE_MAX    1024      // Instructions in a compiled bot script (jump targets are 16-bit)
+#define SCRIPT_REGS        256       // Registers: game state, then variables, constants, temporaries
+#define SCRIPT_VARS        32        // Script variables (kept per game, so a --wall tile has its own)
+#define SCRIPT_VAR_BASE    FEATURE_COUNT                  // First variable register
+#define SCRIPT_CONST_BASE  (SCRIPT_VAR_BASE + SCRIPT_VARS) // First constant register
+#define SCRIPT_NAME_MAX    24        // Longest variable name + 1
+#define SCRIPT_LINE_MAX    256       // Longest script line
+#define SCRIPT_DEPTH       16        // Nested ifs
+#define SCRIPT_EXITS       16        // elif/else branches of one if
+
+#define METRICS_WINDOW     256       // Recent frames/ticks the percentiles are taken over (power of two)
+
+#define FLIGHT_RING        4096      // Frames and events the flight recorder keeps (~10 s, power of two)
+#define FLIGHT_HITCH_MS    20.0      // Default frame time that counts as a hitch
+#define FLIGHT_DUMP_GAP    5.0       // Seconds between dumps, so one bad patch writes one file
+
+#define LOG_RING           8192      // Log records buffered per thread before they're dropped (power of two)
+#define LOG_MAX_ARGS       6         // Arguments one log record can carry
+#define LOG_VERSION        1
+
+#define PROFILE_HZ         1000      // Default profiler sampling rate
+#define PROFILE_DEPTH      32        // Deepest call stack a sample keeps
+#define PROFILE_POOL       (1 << 22) // Words of sample storage (a few minutes of samples at 1 kHz)
+
+#define BENCH_RUNS         3         // Default times each replay is timed; the quietest run counts
+#define BENCH_TOLERANCE    0.10      // Slowdown over the baseline (p50 or p90) that counts as a regression
+#define BENCH_NOISE_US     0.5       // ...and by at least this much, so sub-microsecond jitter isn't one
+
+#define ATTRACT_IDLE_TICKS (TICK_RATE*10) // Title screen idle time before recorded games start playing
+#define ATTRACT_READAHEAD  2048      // Ticks of replay input asked for ahead of playback (4 KB)
+
+#define WALL_MAX           64        // Most games one process shows with --wall
+#define WALL_RESTART_TICKS (TICK_RATE*3) // How long a finished tile shows its end screen
+
+#define REWIND_SNAPSHOT_TICKS TICK_RATE // Rewind debugger: a full snapshot every second of play
+#define REWIND_SNAPSHOTS   600       // Most snapshots kept (ten minutes back)...
+#define REWIND_BUDGET_MB   64        // ...or fewer, when a big level's snapshots would need more than this
+#define REWIND_TICKS       (REWIND_SNAPSHOTS*REWIND_SNAPSHOT_TICKS) // Input kept, one uint16_t per tick
+#define REWIND_VELOCITY_SCALE 8.0f   // Overlay velocity lines show where a ball is this many ticks ahead
+
+#define LAYOUT_CACHE       4         // Target sizes whose text layout is kept (window, wall tile, ...)
+#define STARTUP_BUDGET_MS  300       // Process start to first frame; --startup-check fails above this
+#define FONT_SDF_FILE      "arkanoid-sdf.fnt" // Baked font loaded at startup when present (see --bake-font)
+#define FONT_BAKE_SIZE     48        // Glyph size the SDF atlas is baked at; it scales cleanly either way
+#define TEXT_QUEUE_MAX     256       // Strings drawn in one frame (all tiles of a wall included)
+#define TEXT_CHARS_MAX     16384     // Their characters
+
+#define TTY_COLS           96        // Terminal view: characters across (10 playfield units each)
+#define TTY_ROWS           36        // Character rows for the playfield; each shows two pixels (half blocks)
+#define TTY_HZ             10        // Terminal updates per second
+#define TTY_OUT_MAX        (1 << 17) // Escape sequences for one update, worst case (every cell changed)
+
+// Loads/stores for data shared between the game and a worker thread (e.g. the audio mixer)
+#if defined(__GNUC__) || defined(__clang__)
+    #define ATOMIC_LOAD(p)      __atomic_load_n((p), __ATOMIC_ACQUIRE)
+    #define ATOMIC_STORE(p, v)  __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+    #define ATOMIC_ADD(p, v)    __atomic_fetch_add((p), (v), __ATOMIC_RELAXED)   // Returns the old value
+#else
+    #define ATOMIC_LOAD(p)      (*(volatile unsigned int *)(p))     // MSVC on x86/x64: volatile is acquire/release
+    #define ATOMIC_STORE(p, v)  (*(volatile unsigned int *)(p) = (v))
+    #define ATOMIC_ADD(p, v)    InterlockedExchangeAdd((volatile long *)(p), (v))
+#endif
 
 //----------------------------------------------------------------------------------
 // Enumerations - allows readable states and powerup types
@@ -36,6 +231,86 @@ typedef enum e_powerup_type {
     POWERUP_MULTI_BALL               // Splits ball into more balls
 } t_powerup_type;
 
+typedef enum e_input_key {
+    INPUT_LEFT = 0,                  // Move paddle left (LEFT arrow)
+    INPUT_RIGHT,                     // Move paddle right (RIGHT arrow)
+    INPUT_LAUNCH,                    // Launch ball / start game (SPACE)
+    INPUT_CONFIRM,                   // Start game / back to title (ENTER)
+    INPUT_PAUSE,                     // Toggle pause (P)
+    INPUT_AUTOPILOT,                 // Toggle the learned autopilot (A)
+    INPUT_KEY_COUNT
+} t_input_key;
+
+typedef enum e_sound {
+    SOUND_PADDLE = 0,                // Ball bounces off the paddle
+    SOUND_BRICK,                     // Brick destroyed
+    SOUND_POWERUP,                   // Powerup collected
+    SOUND_BALL_LOST,                 // Last ball fell off the screen
+    SOUND_COUNT
+} t_sound;
+
+typedef enum e_flight_kind {
+    FLIGHT_FRAME,                    // Phase timings of one frame
+    FLIGHT_STATE,                    // Game state changed (arg: new t_gamestate)
+    FLIGHT_PADDLE,                   // Ball bounced off the paddle
+    FLIGHT_BRICK,                    // Brick destroyed (arg: brick index)
+    FLIGHT_BALL_LOST,                // Life lost (arg: lives left)
+    FLIGHT_POWERUP                   // Powerup collected (arg: t_powerup_type)
+} t_flight_kind;
+
+typedef enum e_log_msg {
+    LOG_GAME_START,
+    LOG_LAUNCH,
+    LOG_PADDLE_HIT,
+    LOG_BRICK,
+    LOG_BALL_LOST,
+    LOG_POWERUP,
+    LOG_GAME_END,
+    LOG_STARTUP,
+    LOG_MESSAGE_COUNT
+} t_log_msg;
+
+typedef enum e_startup_phase {
+    STARTUP_MAIN = 0,                // main() entered
+    STARTUP_WINDOW,                  // InitWindow() returned
+    STARTUP_READY,                   // Assets loaded, worker joined, game set up
+    STARTUP_FIRST_FRAME,             // First EndDrawing() returned
+    STARTUP_PHASES
+} t_startup_phase;
+
+typedef enum e_text_item {
+    TEXT_TITLE,                      // Title screen
+    TEXT_CREDIT,
+    TEXT_HELP_FIRST,
+    TEXT_HELP_LAST = TEXT_HELP_FIRST + 7,
+    TEXT_SCORE,                      // In game
+    TEXT_AUTOPILOT,
+    TEXT_DEMO,
+    TEXT_PAUSED,
+    TEXT_REWIND,                     // Rewind debugger, frozen
+    TEXT_REWIND_HINT,
+    TEXT_OVER,                       // Game over screen
+    TEXT_OVER_SCORE,
+    TEXT_OVER_HINT,
+    TEXT_WIN,                        // Victory screen
+    TEXT_WIN_SCORE,
+    TEXT_WIN_CLEARED,
+    TEXT_WIN_HINT,
+    TEXT_COUNT
+} t_text_item;
+
+typedef enum e_text_align {
+    ALIGN_LEFT,                      // x is the left edge
+    ALIGN_CENTER,                    // x is the offset of the centre from the middle of the playfield
+    ALIGN_RIGHT                      // x is the gap between the right edge and the playfield's
+} t_text_align;
+
+typedef enum e_audio_backend {
+    AUDIO_NULL = 0,                  // No output at all (no sound card, or it failed to open)
+    AUDIO_DEVICE,                    // Mixed on raylib's audio thread, straight to the sound card
+    AUDIO_WAV                        // Mixed once per tick on the game thread and written to a WAV file
+} t_audio_backend;
+
 //----------------------------------------------------------------------------------
 // Structure Definitions - represents major game "objects"
 //----------------------------------------------------------------------------------
@@ -57,201 +332,4356 @@ typedef struct s_ball
     bool active;                     // Is the ball in play/moving (true) or at rest (false)
 } t_ball;
 
-typedef struct s_brick
+typedef struct s_brick
+{
+    Rectangle rect;                  // Rectangle for brick position/size (bounding box for polygons)
+    Color color;                     // Fill color
+    int leaf;                        // BVH leaf this brick sits in
+    int poly;                        // Index into brickPolys, -1 for a plain rectangle
+} t_brick;
+
+typedef struct s_brick_poly
+{
+    Vector2 v[BRICK_POLY_VERTS];     // Corners, counter-clockwise on screen (raylib's fan order)
+    float nx[BRICK_POLY_VERTS];      // Outward normal of edge k (v[k] -> v[k+1]), x part
+    float ny[BRICK_POLY_VERTS];      // ...and y part
+    float d[BRICK_POLY_VERTS];       // Edge offset: n.p - d > 0 means p is outside edge k
+    int count;                       // Corners in use; spare plane slots repeat edge 0
+} t_brick_poly;
+
+typedef struct s_brick_batch
+{
+    float minX[BRICK_BATCH];         // Candidate boxes, one lane each (structure of arrays
+    float minY[BRICK_BATCH];         // so the test runs across all lanes at once)
+    float maxX[BRICK_BATCH];
+    float maxY[BRICK_BATCH];
+    int brick[BRICK_BATCH];          // Which brick each lane holds
+    int count;                       // Lanes filled
+} t_brick_batch;
+
+typedef struct s_poly_batch
+{
+    float nx[BRICK_POLY_VERTS][BRICK_BATCH]; // Edge planes of the candidate polygons, one lane each,
+    float ny[BRICK_POLY_VERTS][BRICK_BATCH]; // so the separating axis test runs across all lanes at once
+    float d[BRICK_POLY_VERTS][BRICK_BATCH];
+    int brick[BRICK_BATCH];          // Which brick each lane holds
+    int count;                       // Lanes filled
+} t_poly_batch;
+
+typedef struct s_contact
+{
+    int brick;                       // Index into bricks[]
+    Vector2 normal;                  // Unit normal pointing from the brick towards the ball center
+} t_contact;
+
+typedef struct s_bvh_node
+{
+    float minX, minY, maxX, maxY;    // Bounds of the standing bricks below this node
+    int first;                       // Leaf: first brick index; inner node: left child (right is first + 1)
+    int count;                       // Leaf: number of bricks; 0 for inner nodes
+    int parent;                      // Parent node (-1 for the root)
+    int alive;                       // Standing bricks below this node; 0 = whole subtree skipped
+} t_bvh_node;
+
+typedef struct s_powerup
+{
+    Vector2 pos;                     // Powerup position (center x, y)
+    Vector2 spd;                     // Powerup falling speed (y only)
+    t_powerup_type type;             // Which powerup this is (expand, life, multi-ball)
+    bool active;                     // Is powerup still falling/visible
+} t_powerup;
+
+typedef struct s_input_event
+{
+    double time;                     // GetTime() when the change was sampled
+    t_input_key key;                 // Which game key changed
+    bool down;                       // true = pressed, false = released
+} t_input_event;
+
+typedef struct s_voice
+{
+    const float *pcm;                // Samples being played, NULL = voice free
+    int length;                      // Frames in pcm
+    int pos;                         // Next frame to mix
+    float gain;                      // Volume 0..1
+} t_voice;
+
+typedef struct s_sound_cmd
+{
+    t_sound sound;                   // What to play
+    float gain;                      // How loud
+} t_sound_cmd;
+
+typedef struct s_input
+{
+    unsigned int down;               // Bitmask of keys held during this tick
+    unsigned int pressed;            // Bitmask of keys that went down during this tick
+} t_input;
+
+typedef struct s_replay_header
+{
+    char magic[4];                   // "ARKR"
+    uint32_t version;                // REPLAY_VERSION
+    uint32_t seed;                   // Seed the game's RNG started from
+    uint32_t ticks;                  // Ticks that follow, one uint16_t of input each (down | pressed << 8)
+    char level[REPLAY_LEVEL_CHARS];  // Level file the game used ("" = default grid)
+} t_replay_header;
+
+typedef enum e_feature {
+    FEATURE_PADDLE_X = 0,            // Paddle center
+    FEATURE_PADDLE_W,                // Paddle width (expand powerup)
+    FEATURE_BALL_X,                  // Lowest active ball (or the one waiting on the paddle)
+    FEATURE_BALL_Y,
+    FEATURE_BALL_VX,
+    FEATURE_BALL_VY,
+    FEATURE_BALLS,                   // Balls in play
+    FEATURE_BRICKS_LEFT,             // Bricks still standing
+    FEATURE_LIVES,                   // Lives left
+    FEATURE_POWERUP_X,               // Lowest falling powerup (-1 if none)
+    FEATURE_POWERUP_Y,
+    FEATURE_COUNT
+} t_feature;
+
+typedef struct s_mlp
+{
+    int layers;                      // Number of weight layers
+    int width[MLP_MAX_LAYERS + 1];   // Units per layer as stored in the file (width[0] = inputs)
+    int padded[MLP_MAX_LAYERS + 1];  // Same, rounded up to MLP_LANES
+    float weights[MLP_MAX_LAYERS][MLP_MAX_WIDTH*MLP_MAX_WIDTH]; // Transposed: [input][output], zero padded
+    float bias[MLP_MAX_LAYERS][MLP_MAX_WIDTH];
+} t_mlp;
+
+typedef enum e_script_op {
+    // Instruction: op | a << 8 | b << 16 | c << 24, registers a = b op c; jumps keep their target in b|c
+    SCRIPT_MOV = 0, SCRIPT_ADD, SCRIPT_SUB, SCRIPT_MUL, SCRIPT_DIV,
+    SCRIPT_LT, SCRIPT_LE, SCRIPT_EQ, SCRIPT_NE, SCRIPT_AND, SCRIPT_OR, SCRIPT_NOT,
+    SCRIPT_NEG, SCRIPT_ABS, SCRIPT_MIN, SCRIPT_MAX,
+    SCRIPT_JMP,                      // Always jump
+    SCRIPT_JZ,                       // Jump if register a is 0
+    SCRIPT_KEY,                      // Press key a (t_input_key) this tick
+    SCRIPT_HALT,                     // End of the script
+    SCRIPT_OP_COUNT
+} t_script_op;
+
+typedef struct s_script
+{
+    uint32_t code[SCRIPT_CODE_MAX];
+    int length;                      // Instructions, the final SCRIPT_HALT included (0: none loaded)
+    int vars;                        // Variables in use
+    int constEnd;                    // One past the last constant register
+    float regs[SCRIPT_REGS];         // Only thing a run writes to; no allocation while running
+    char varNames[SCRIPT_VARS][SCRIPT_NAME_MAX];
+} t_script;
+
+typedef struct s_metrics_totals
+{
+    // Running totals as of one frame; the sums are 64-bit, stored as two halves
+    unsigned int frames, ticks;              // How many frames/ticks the sums cover
+    unsigned int frameUsLow, frameUsHigh;    // All frame times, microseconds
+    unsigned int tickNsLow, tickNsHigh;      // All tick costs, nanoseconds
+} t_metrics_totals;
+
+typedef struct s_metrics
+{
+    // Written only by the frame loop with ATOMIC_STORE, read by the metrics thread with ATOMIC_LOAD
+    unsigned int frames;                     // Frames drawn so far
+    unsigned int ticks;                      // Simulation ticks run so far
+    unsigned int frameUs[METRICS_WINDOW];    // Last frame times, microseconds (ring indexed by frames)
+    unsigned int tickNs[METRICS_WINDOW];     // Last tick costs, nanoseconds (ring indexed by ticks)
+    unsigned int balls, powerups, bricks;    // Entity counts after the last frame
+    unsigned int state;                      // t_gamestate
+    t_metrics_totals totals[2];              // Written alternately, totals[totalsFrame & 1] is the latest
+    unsigned int totalsFrame;                // Bumped after each write of totals
+    uint64_t frameUsSum, tickNsSum;          // Frame loop's own running sums (never read by the thread)
+} t_metrics;
+
+typedef struct s_flight_entry
+{
+    double time;                     // GetTime() for frames, simulation time for events
+    unsigned int kind;               // t_flight_kind
+    unsigned int arg;                // Event detail, see t_flight_kind
+    float ms[4];                     // FLIGHT_FRAME: update, draw, present, wait (milliseconds)
+} t_flight_entry;
+
+typedef struct s_flight_snapshot
+{
+    // Game state at the moment a hitch was noticed, written next to the ring
+    double time;                     // When the hitch was noticed
+    float hitchMs;                   // How long the slow frame took
+    t_gamestate state;
+    int score, bricksLeft;
+    uint32_t seed;
+    t_player player;
+    t_ball balls[BALLS_MAX];
+    t_powerup powerups[POWERUPS_MAX];
+    char level[256];                 // levelPath copied at the hitch (attract mode may switch it meanwhile)
+} t_flight_snapshot;
+
+typedef struct s_log_message
+{
+    const char *format;              // printf format, applied only when the log is decoded
+    const char *args;                // One letter per argument: 'i' int, 'f' float (passed as double)
+} t_log_message;
+
+typedef struct s_log_record
+{
+    double time;                     // Simulation time
+    uint16_t msg;                    // t_log_msg
+    uint16_t argc;
+    uint32_t args[LOG_MAX_ARGS];     // Raw argument bits (ints, or floats by memcpy)
+} t_log_record;
+
+typedef struct s_log_ring
+{
+    // Single producer (the thread that owns it), single consumer (the log writer thread)
+    t_log_record records[LOG_RING];
+    unsigned int head;               // Written by the owner
+    unsigned int tail;               // Written by the log writer
+    unsigned int dropped;            // Records lost because the writer fell behind
+} t_log_ring;
+
+typedef struct s_replay_stream
+{
+    // A replay read straight from a mapped file, one tick at a time
+    t_replay_header header;
+    const uint16_t *inputs;          // Inside the mapping, header.ticks entries
+    void *map;                       // Whole file (NULL when closed)
+    size_t mapSize;
+    uint32_t next;                   // Next tick to hand out
+} t_replay_stream;
+
+typedef struct s_game_instance
+{
+    // Everything that differs between the games on a --wall; the level itself is shared
+    t_player player;
+    t_ball balls[BALLS_MAX];
+    int ballsCount;
+    t_powerup powerups[POWERUPS_MAX];
+    int bricksLeft;
+    int score;
+    t_gamestate gameState;
+    bool paused;
+    bool waitingForLaunch;
+    uint32_t gameSeed, rngState;
+    int endTicks;                    // Ticks spent on the game over/win screen
+    float scriptVars[SCRIPT_VARS];   // The bot script's variables for this game
+    uint64_t *bricksAlive;           // Level-sized copies of the brick mask and BVH
+    t_bvh_node *bvh;
+} t_game_instance;
+
+typedef enum e_rewind_key {
+    REWIND_KEY_FREEZE = 0,           // F9: freeze / play on
+    REWIND_KEY_BACK,                 // Comma: one tick back
+    REWIND_KEY_FORWARD,              // Period: one tick forward
+    REWIND_KEY_BACK_SECOND,          // Page up: a second back
+    REWIND_KEY_FORWARD_SECOND,       // Page down: a second forward
+    REWIND_KEY_COUNT
+} t_rewind_key;
+
+typedef struct s_rewind_view
+{
+    // What the last tick did, kept for the rewind debugger's overlay
+    t_contact contacts[BALLS_MAX][BALL_CONTACTS_MAX];
+    int contactsCount[BALLS_MAX];
+    unsigned int paddleHits;         // Bit b: ball b bounced off the paddle
+} t_rewind_view;
+
+typedef struct s_text_spec
+{
+    const char *text;                // Text, or for numbers the widest it gets (used to centre it)
+    t_text_align align;
+    int x, y;                        // Playfield units (960x720), see t_text_align
+    int size;                        // Font size in playfield units
+    Color color;
+} t_text_spec;
+
+typedef struct s_layout
+{
+    // Everything draw_game() needs for one target size, worked out once
+    int width, height;               // Target size this layout is for (0 = unused slot)
+    float scale;                     // Playfield units to pixels
+    Vector2 view;                    // Top-left of the (letterboxed) playfield in the target
+    Vector2 textPos[TEXT_COUNT];     // Pixel positions relative to the target
+    int textSize[TEXT_COUNT];        // Pixel font sizes
+} t_layout;
+
+typedef struct s_text_draw
+{
+    int offset;                      // Into textChars
+    Vector2 pos;                     // Pixels
+    float size;                      // Pixels
+    Color color;
+} t_text_draw;
+
+typedef struct s_tty_cell
+{
+    char ch;                         // 0: upper half block (fg = top pixel, bg = bottom), else ASCII
+    uint8_t fg, bg;                  // xterm-256 colour indices
+} t_tty_cell;
+
+typedef struct s_dataset
+{
+    float *features[FEATURE_COUNT];  // One column per feature
+    uint8_t *action;                 // bit0 left held, bit1 right held, bit2 launch pressed
+    uint32_t *replay;                // Line of the replay in the list file
+    uint32_t *tick;                  // Tick within that replay
+    uint32_t rows;                   // Rows filled
+    uint32_t capacity;               // Rows that fit in one shard
+} t_dataset;
+
+//------------------------------------------------------------------------------------
+// Global Variables - accessible everywhere in file for game state
+//------------------------------------------------------------------------------------
+static const int screenWidth = 960;         // Playfield width; everything in the game is in these units
+static const int screenHeight = 720;        // Playfield height; the window may be any size
+#ifndef ARKANOID_CORE
+static int windowWidth = 960;               // --size: initial window size (the window can be resized)
+static int windowHeight = 720;
+static t_layout layouts[LAYOUT_CACHE];      // Text/HUD layouts for recently drawn target sizes
+static const char *fontPath = FONT_SDF_FILE; // --font: baked SDF font (.fnt + .png)
+static Font sdfFont = { 0 };                // texture.id 0: not loaded, text uses the default font
+static Shader sdfShader = { 0 };
+static t_text_draw textQueue[TEXT_QUEUE_MAX]; // This frame's strings, drawn together by flush_text()
+static int textQueued = 0;
+static char textChars[TEXT_CHARS_MAX];
+static int textCharsUsed = 0;
+static const char *sdfFragmentShader =
+    "#version 330\n"
+    "in vec2 fragTexCoord;\n"
+    "in vec4 fragColor;\n"
+    "uniform sampler2D texture0;\n"
+    "uniform vec4 colDiffuse;\n"
+    "out vec4 finalColor;\n"
+    "void main()\n"
+    "{\n"
+    "    // Distance 0.5 is the glyph edge; smooth over one screen pixel whatever the size\n"
+    "    float d = texture(texture0, fragTexCoord).a - 0.5;\n"
+    "    float w = length(vec2(dFdx(d), dFdy(d)));\n"
+    "    finalColor = vec4(fragColor.rgb, fragColor.a*smoothstep(-w, w, d))*colDiffuse;\n"
+    "}\n";
+static int layoutNext = 0;                  // Slot the next new size replaces
+// raylib's colour macros are compound literals, which ISO C doesn't accept in a static initializer,
+// so the colours are written out (same values: LIGHTGRAY, RAYWHITE, YELLOW, ...)
+static const t_text_spec textSpecs[TEXT_COUNT] = {
+    [TEXT_TITLE]       = { "Arkanoid", ALIGN_CENTER, 0, 120, 110, { 255, 180, 60, 255 } },
+    [TEXT_CREDIT]      = { "Made by --> Yash Shah", ALIGN_RIGHT, 24, 720 - 44, 28, { 200, 200, 200, 255 } },
+    [TEXT_HELP_FIRST]  = { "Press SPACE or ENTER to start", ALIGN_CENTER, 0, 290, 26, { 245, 245, 245, 255 } },
+    [TEXT_HELP_FIRST + 1] = { "Move paddle: LEFT / RIGHT arrow keys", ALIGN_CENTER, 0, 290 + 32, 26, { 245, 245, 245, 255 } },
+    [TEXT_HELP_FIRST + 2] = { "Launch ball: SPACE", ALIGN_CENTER, 0, 290 + 64, 26, { 245, 245, 245, 255 } },
+    [TEXT_HELP_FIRST + 3] = { "Pause/Resume: P", ALIGN_CENTER, 0, 290 + 96, 26, { 245, 245, 245, 255 } },
+    [TEXT_HELP_FIRST + 4] = { "Clear all bricks to win!", ALIGN_CENTER, 0, 290 + 128, 26, { 245, 245, 245, 255 } },
+    [TEXT_HELP_FIRST + 5] = { "", ALIGN_CENTER, 0, 290 + 160, 26, { 245, 245, 245, 255 } },
+    [TEXT_HELP_FIRST + 6] = { "Powerups:", ALIGN_CENTER, 0, 290 + 192, 26, { 245, 245, 245, 255 } },
+    [TEXT_HELP_LAST]   = { "   E = Expand Paddle,   + = Extra Life,   Three Balls = Multi-ball", ALIGN_CENTER, 0, 290 + 224, 26, { 245, 245, 245, 255 } },
+    [TEXT_SCORE]       = { "SCORE: %04i", ALIGN_LEFT, 960 - 170, 20, 28, { 253, 249, 0, 255 } },
+    [TEXT_AUTOPILOT]   = { "AUTOPILOT", ALIGN_LEFT, 20, 20, 28, { 102, 191, 255, 255 } },
+    [TEXT_DEMO]        = { "DEMO - press any key", ALIGN_CENTER, 0, 720/2 + 60, 32, { 255, 180, 60, 255 } },
+    [TEXT_PAUSED]      = { "GAME PAUSED", ALIGN_CENTER, 0, 720/2 - 48, 48, { 130, 130, 130, 255 } },
+    [TEXT_REWIND]      = { "REWIND  TICK 000000 / 000000", ALIGN_CENTER, 0, 60, 28, { 0, 228, 48, 255 } },
+    [TEXT_REWIND_HINT] = { ", .  one tick    PGUP PGDN  one second    F9  play on", ALIGN_CENTER, 0, 94, 20, { 200, 200, 200, 255 } },
+    [TEXT_OVER]        = { "GAME OVER", ALIGN_CENTER, 0, 720/2 - 80, 56, { 230, 41, 55, 255 } },
+    [TEXT_OVER_SCORE]  = { "FINAL SCORE: 0000", ALIGN_CENTER, 0, 720/2, 32, { 190, 33, 55, 255 } },
+    [TEXT_OVER_HINT]   = { "PRESS [ENTER] TO RETURN TO TITLE", ALIGN_CENTER, 0, 720/2 + 72, 26, { 80, 80, 80, 255 } },
+    [TEXT_WIN]         = { "VICTORY!", ALIGN_CENTER, 0, 720/2 - 96, 64, { 253, 249, 0, 255 } },
+    [TEXT_WIN_SCORE]   = { "FINAL SCORE: 0000", ALIGN_CENTER, 0, 720/2, 34, { 190, 33, 55, 255 } },
+    [TEXT_WIN_CLEARED] = { "YOU CLEARED ALL THE BRICKS!", ALIGN_CENTER, 0, 720/2 + 48, 28, { 255, 161, 0, 255 } },
+    [TEXT_WIN_HINT]    = { "PRESS [ENTER] TO RETURN TO TITLE", ALIGN_CENTER, 0, 720/2 + 96, 26, { 80, 80, 80, 255 } },
+};
+#endif
+
+static t_player player = { 0 };             // One player struct, initialized to all zeros
+static t_ball balls[BALLS_MAX] = { 0 };     // Array of all possible balls (max BALLS_MAX)
+static int ballsCount = 1;                  // Current number of balls active/in play
+#ifdef ARKANOID_CORE
+static t_brick bricks[BRICKS_MAX] = { 0 };  // No heap in the core: fixed arrays for the default grid
+static t_brick_poly brickPolys[BRICK_POLYS_MAX];
+static uint64_t bricksAlive[BRICK_WORDS] = { 0 };
+static t_bvh_node bvh[BVH_NODES_MAX];
+static t_bvh_node levelBvh[BVH_NODES_MAX];
+#else
+static t_brick *bricks = NULL;              // Level layout, in BVH leaf order; never changes during a game
+static t_brick_poly *brickPolys = NULL;     // Shapes of the non-rectangular bricks
+static uint64_t *bricksAlive = NULL;        // Bit i set = bricks[i] still standing; zero words are skipped
+static t_bvh_node *bvh = NULL;              // Brick BVH for this game, pruned and refit as bricks break
+static t_bvh_node *levelBvh = NULL;         // BVH as built at load, copied into bvh for each new game
+static int bricksCapacity = 0;              // All five are sized to the level when it loads
+static int brickPolysCapacity = 0;
+#endif
+static int bricksCount = 0;                 // Number of bricks in the level
+static int brickPolysCount = 0;             // Polygons in use
+static int bricksLeft = 0;                  // Bricks still standing in the whole field
+static int bvhCount = 0;                    // Nodes in use (same for bvh and levelBvh)
+static t_gamestate gameState = GAME_TITLE;  // Overall game state (starts at title screen)
+static bool paused = false;                 // Is the game currently paused?
+static int score = 0;                       // Player score (starts at 0)
+static t_powerup powerups[POWERUPS_MAX] = { 0 }; // Array of possible falling powerups
+static bool waiting_for_launch = true;      // Between life loss and ball ready for relaunch
+static t_input input = { 0 };               // Key state the current tick runs with
+static uint32_t gameSeed = 1;               // Seed init_game() starts the RNG from
+static uint32_t rngState = 1;               // Game RNG; all gameplay randomness comes from here
+static bool levelReady = false;             // Set once bricks/levelBvh are built; checked before GAME_PLAYING
+
+#ifdef ARKANOID_CORE
+// Everything above is the core's whole state; a negative array size stops the build if it outgrows the budget
+#define CORE_STATE_SIZE (sizeof(player) + sizeof(balls) + sizeof(ballsCount) + sizeof(bricks) + sizeof(bricksCount) + \
+                         sizeof(brickPolys) + sizeof(brickPolysCount) + sizeof(bricksAlive) + sizeof(bricksLeft) + \
+                         sizeof(bvh) + sizeof(bvhCount) + sizeof(gameState) + sizeof(paused) + sizeof(score) + \
+                         sizeof(powerups) + sizeof(waiting_for_launch) + sizeof(input) + sizeof(gameSeed) + \
+                         sizeof(rngState) + sizeof(levelBvh) + sizeof(levelReady))
+typedef char core_state_over_budget[(CORE_STATE_SIZE <= CORE_STATE_BUDGET) ? 1 : -1];
+const uint32_t coreStateSize = CORE_STATE_SIZE;   // Kept in the object so the footprint can be read back
+#else
+// Input: sampled at INPUT_POLL_HZ into a ring of timestamped events, drained tick by tick
+static const int inputKeyMap[INPUT_KEY_COUNT] = { KEY_LEFT, KEY_RIGHT, KEY_SPACE, KEY_ENTER, KEY_P, KEY_A };
+static t_input_event inputQueue[INPUT_QUEUE_SIZE]; // Ring buffer of key changes not yet seen by a tick
+static unsigned int inputHead = 0;          // Next slot poll_input() writes
+static unsigned int inputTail = 0;          // Next slot consume_input() reads
+static unsigned int inputSampled = 0;       // Key bitmask as of the last sample
+static unsigned int inputTapped = 0;        // Movement keys down for the last tick only: tapped and released within it
+static double simTime = 0.0;                // Time the simulation has been advanced to
+static double nextFrameTime = 0.0;          // When the next frame should start
+
+// Audio: the game pushes play requests into a lock-free ring, the mixer owns the voices
+static float soundPcm[SOUND_COUNT][SOUND_MAX_FRAMES]; // Synthesized sound effects
+static int soundLength[SOUND_COUNT] = { 0 };  // Frames used in each
+static t_voice voices[AUDIO_VOICES] = { 0 }; // Only ever touched by the mixer
+static t_sound_cmd soundQueue[AUDIO_QUEUE_SIZE]; // Play requests, game thread -> mixer
+static unsigned int soundHead = 0;          // Written by the game thread only
+static unsigned int soundTail = 0;          // Written by the mixer only
+static t_audio_backend audioBackend = AUDIO_NULL; // Where the mix goes
+static AudioStream audioStream = { 0 };     // Device backend stream, fed by audio_callback()
+static FILE *audioWav = NULL;               // WAV backend output file
+static unsigned int audioWavFrames = 0;     // Frames written to audioWav so far
+static const char *audioWavPath = NULL;     // --audio-wav file (NULL = use the sound card)
+
+// Replays: the seed plus one input word per tick is enough to play a game again exactly
+static const char *recordDir = NULL;        // --record directory (NULL = don't record)
+static bool recording = false;              // A replay is being captured right now
+static t_replay_header replayHeader = { 0 }; // Header of the replay being recorded
+static uint16_t replayInputs[REPLAY_MAX_TICKS]; // Its inputs (also the load buffer for re-simulation)
+static char replayLevel[REPLAY_LEVEL_CHARS] = { 0 }; // Level path of the replay being re-simulated
+static t_metrics metrics = { 0 };           // Published once per frame for --metrics
+static const char *metricsPath = NULL;      // --metrics socket path
+static double lastFrameTime = 0.0;          // GetTime() at the start of the previous frame
+#ifndef _WIN32
+static int metricsSocket = -1;              // Listening socket, -1 when the endpoint is off
+static pthread_t metricsThread;
+#endif
+static t_flight_entry flightRing[FLIGHT_RING];  // Flight recorder; only the frame loop writes it
+static unsigned int flightHead = 0;         // Entries written so far (ring index = flightHead % FLIGHT_RING)
+static const char *flightDir = NULL;        // --flight-dir: where hitch dumps go (NULL = watchdog off)
+static double hitchMs = FLIGHT_HITCH_MS;    // --hitch-ms
+static double lastDumpTime = -FLIGHT_DUMP_GAP;
+static t_flight_entry flightDump[FLIGHT_RING];  // Copy handed to the dump thread
+static t_flight_snapshot flightSnapshot;
+static unsigned int flightDumpHead = 0;
+static unsigned int flightDumpBusy = 0;     // Set by the frame loop, cleared by the dump thread when written
+#ifndef _WIN32
+static sem_t flightWake;
+static pthread_t flightThread;
+static bool flightThreadRunning = false;
+#endif
+static const t_log_message logMessages[LOG_MESSAGE_COUNT] = {
+    [LOG_GAME_START] = { "game start: seed %u, %d bricks", "ii" },
+    [LOG_LAUNCH]     = { "ball launched, vx %.1f", "f" },
+    [LOG_PADDLE_HIT] = { "ball %d hit the paddle at %+.2f", "if" },
+    [LOG_BRICK]      = { "ball %d destroyed brick %d at (%.0f, %.0f), score %d", "iiffi" },
+    [LOG_BALL_LOST]  = { "life lost, %d left", "i" },
+    [LOG_POWERUP]    = { "powerup %d collected", "i" },
+    [LOG_GAME_END]   = { "game ended: state %d, score %d", "ii" },
+    [LOG_STARTUP]    = { "startup: process %.0f ms, window %.1f ms, setup %.1f ms, first frame %.1f ms", "ffff" },
+};
+static t_log_ring gameLog;                  // The game thread's log; other threads would get their own
+static FILE *logFile = NULL;                // --log output (NULL = logging off)
+static const char *logPath = NULL;
+#ifndef _WIN32
+static sem_t logWake;
+static pthread_t logThread;
+static bool logThreadRunning = false;
+#endif
+static const char *profilePath = NULL;      // --profile output (collapsed stacks)
+static int profileHz = PROFILE_HZ;          // --profile-hz
+static uintptr_t *profilePool = NULL;       // Samples: a depth word, then that many return addresses (leaf first)
+static unsigned int profileUsed = 0;        // Words of profilePool taken
+static unsigned int profileDropped = 0;     // Samples that didn't fit
+static uintptr_t profileStackTop = 0;       // Frame pointers above this aren't on the main stack
+static char **attractPaths = NULL;          // --attract list of replays shown on an idle title screen
+static int attractCount = 0;
+static int attractNext = 0;                 // Next list entry the prefetcher tries
+static t_replay_stream attractStreams[2];   // The one playing and the one being prefetched
+static int attractPlaying = 1;              // Index into attractStreams
+static unsigned int attractReady = 0;       // Prefetcher: 1 = next stream open, 2 = nothing in the list opens
+static bool attractOn = false;              // A recorded game is being shown
+static int attractIdle = 0;                 // Title ticks without input
+static const char *attractLevel = NULL;     // levelPath to put back when the player takes over
+#ifndef _WIN32
+static pthread_t attractThread;
+static bool attractThreadBusy = false;
+#endif
+static const char *ttyPath = NULL;          // --tty: terminal to mirror the game to ("-" = stdout)
+#ifndef _WIN32
+static int ttyFd = -1;
+static int ttyFlags = 0;                    // File status flags to restore (stdout is shared with the shell)
+#endif
+static t_tty_cell ttyCells[TTY_ROWS + 1][TTY_COLS]; // Last picture sent (extra row: status line)
+static char ttyOut[TTY_OUT_MAX];            // Bytes of the current update
+static int ttyOutLength = 0, ttyOutSent = 0; // An update is only replaced once it has gone out completely
+static double ttyLastTime = 0.0;
+static bool rewindEnabled = false;          // --rewind: keep history for the debugger
+static t_game_instance *rewindSnaps = NULL; // Ring of rewindSnapCount snapshots, one per REWIND_SNAPSHOT_TICKS
+static int rewindSnapCount = 0;
+static char *rewindMemory = NULL;           // Their brick masks and BVHs
+static size_t rewindMemorySize = 0;
+static uint16_t rewindInputs[REWIND_TICKS]; // Input of every tick, down | pressed << 8 (as in replays)
+static int rewindFirst = 0, rewindTick = 0, rewindLatest = 0; // Ticks since the game started: oldest, shown, newest
+static bool rewindLive = false;             // The current game is being recorded
+static bool rewindFrozen = false;           // Debugger is showing rewindTick; ticks only run when stepped
+static unsigned int rewindKeys = 0;         // Debugger keys pressed since the last frame (t_rewind_key bits)
+static t_rewind_view rewindView = { 0 };    // What the tick on screen did, cleared as each tick starts
+static bool rewindReplaying = false;        // rewind_seek() is running ticks again: their events were logged the first time
+static const int rewindKeyMap[REWIND_KEY_COUNT] = { KEY_F9, KEY_COMMA, KEY_PERIOD, KEY_PAGE_UP, KEY_PAGE_DOWN };
+static double startupTime[STARTUP_PHASES];  // startup_clock() as each t_startup_phase was reached
+static double startupProcessMs = -1.0;      // Process start to main(), -1 if unknown
+static double startupWorkerMs = 0.0;        // Time the startup worker took
+static bool startupCheck = false;           // --startup-check: report startup and exit after the first frame
+static double startupBudgetMs = STARTUP_BUDGET_MS; // --startup-budget
+static int exitCode = 0;                    // main()'s return value once the loop ends
+#ifndef _WIN32
+static pthread_t startupThread;
+static bool startupWorkerRunning = false;
+#endif
+static t_game_instance *wall = NULL;        // --wall games, swapped into the globals one at a time
+static int wallCount = 0;
+static float wallFeatures[WALL_MAX][FEATURE_COUNT]; // Each game's state as the next tick starts, for one batched network pass
+static bool soundMuted = false;             // Wall tiles other than the first play silently
+static t_mlp autopilot = { 0 };             // Learned paddle controller (layers == 0: none loaded)
+static const char *autopilotPath = NULL;    // --autopilot weights file
+static bool autopilotOn = false;            // Driving the paddle right now (toggle with A)
+static t_script script = { 0 };             // Scripted paddle controller (length == 0: none loaded)
+static const char *scriptPath = NULL;       // --script source file
+static const char *featureNames[FEATURE_COUNT] = {
+    "paddle_x", "paddle_w", "ball_x", "ball_y", "ball_vx", "ball_vy",
+    "balls", "bricks_left", "lives", "powerup_x", "powerup_y"
+};
+
+// Work done ahead of time while the title screen is idle
+static RenderTexture2D backgroundTex = { 0 }; // Background gradient, baked once instead of 180 rects a frame
+static const char *levelPath = NULL;        // Free-form level file from --level (NULL = default grid)
+#ifndef _WIN32
+static pthread_t levelThread;
+static bool levelThreadBusy = false;        // prepare_level_async() started a build; nothing else touches the level until it's joined
+#endif
+#endif
+
+//------------------------ ------------------------------------------------------------
+// Function Prototypes - tells compiler what functions exist below
+//------------------------------------------------------------------------------------
+void   init_game(void);                    // Sets up all game variables for new game/start
+void   load_assets(void);                  // Bakes textures that never change
+void   unload_assets(void);                // Frees what load_assets() created
+void   prepare_level(void);                // Builds the next game's brick layout now (waits for a background build)
+void   prepare_level_async(void);          // Same, on a thread, for idle title-screen ticks
+void   wait_level(void);                   // Joins a background build before levelPath/levelReady change
+void   update_game(void);                  // Steps game logic according to game state
+void   draw_game(Rectangle target);        // Draws all objects depending on game state, scaled into target
+const t_layout *get_layout(int width, int height); // Cached text/HUD placement for a target size
+int    bake_font(const char *ttfPath, const char *fntPath); // --bake-font: SDF atlas + BMFont metrics
+void   flush_text(void);                   // Draws every string queued this frame in one batch
+void   start_tty(void);                    // Opens the --tty terminal
+void   update_tty(double now);             // Sends changed cells, at most TTY_HZ times a second
+void   stop_tty(void);
+int    run_headless(void);                 // --headless: no window, the policy plays into the --tty view
+void   update_draw_frame(void);            // Calls update/draw per frame
+void   spawn_powerup(Vector2 pos);         // Creates a powerup object at brick coords
+void   apply_powerup(t_powerup_type type); // Applies effect of collected powerup
+void   reset_balls(Vector2 pos);           // Resets all balls after loss
+void   poll_input(void);                   // Samples keyboard, queues timestamped changes
+void   consume_input(double tickEnd);      // Applies queued changes up to tickEnd to `input`
+void   wait_for_next_frame(void);          // Paces frames while sampling input
+void   init_audio(void);                   // Makes the sound effects and opens the audio backend
+void   close_audio(void);                  // Stops the mixer, finishes the WAV file
+void   play_sound(t_sound sound, float gain); // Queues a sound effect (safe to call from the game loop)
+void   render_audio_tick(void);            // WAV backend: mixes one tick's worth of audio
+int    game_random(int min, int max);      // Deterministic random value in [min, max]
+void   step_game(void);                    // One tick: update_game() plus replay recording
+bool   load_replay(const char *path, t_replay_header *header, uint16_t *inputs);
+void   start_replay_game(const t_replay_header *header); // Sets up a game exactly as a replay began
+int    convert_replays(const char *listPath, const char *outPrefix, int jobs, int shardMB);
+int    bench_replays(const char *listPath, const char *baselinePath, const char *outPath, int runs);
+bool   load_mlp(t_mlp *net, const char *path);  // Reads a flat weights file (see README)
+void   mlp_forward(const t_mlp *net, const float *in, float *out, int batch);
+void   press_policy_keys(const float out[3]); // Policy outputs (left, right, launch) become this tick's keys
+void   toggle_autopilot(void);             // A key: hands the paddle to the policy or takes it back
+void   apply_autopilot(void);              // Lets the network press the keys for this tick
+int    autopilot_eval(int games);          // Headless games played by the autopilot, with timings
+bool   load_script(t_script *s, const char *path); // Compiles a bot script, errors go to stderr
+unsigned int run_script(t_script *s, const float *features); // One tick; returns a bitmask of keys
+void   start_metrics(void);                // Opens the --metrics socket and its serving thread
+void   stop_metrics(void);
+void   publish_metrics(double frameSeconds); // Frame loop side: hands this frame's numbers over
+void   publish_tick(double tickSeconds);   // Same for one tick of the simulation
+void   flight_event(t_flight_kind kind, unsigned int arg); // Appends a gameplay event to the flight recorder
+void   flight_frame(double start, const float ms[4]); // Records a frame's phases and checks its budget
+void   start_flight_recorder(void);
+void   stop_flight_recorder(void);
+void   log_msg(t_log_msg msg, ...);        // Records an ID and raw arguments; formatting happens when decoding
+void   start_log(void);                    // Opens --log and its writer thread
+void   stop_log(void);
+void   flush_log(void);                    // Once per frame: wakes the writer
+int    decode_log(const char *path);       // --decode-log: prints a binary log as text
+void   start_profiler(void *stackTop);     // SIGPROF sampling at --profile-hz, written out at exit
+bool   open_replay_stream(t_replay_stream *stream, const char *path);
+void   close_replay_stream(t_replay_stream *stream);
+void   start_attract(const char *listPath);  // Loads the --attract list and prefetches its first replay
+void   update_attract(void);               // Per tick: starts, feeds, switches or stops the shown game
+void   stop_attract(void);
+void   start_wall(int count);              // Sets up --wall games, all on the current level
+void   update_draw_wall(void);             // Wall version of update_draw_frame()
+void   stop_wall(void);
+void   start_rewind(void);                 // --rewind: sets up the debugger's history
+void   rewind_record(t_gamestate before); // After a live tick: its input, and now and then a snapshot
+void   update_rewind(void);                // Debugger keys: freeze, step, play on
+void   stop_rewind(void);
+void   stop_profiler(void);
+void   start_startup_worker(void);         // Level, audio and font prefetch on a thread while the window opens
+void   join_startup_worker(void);
+void   startup_mark(t_startup_phase phase); // Times a startup phase; the last one reports
+
+#ifdef ARKANOID_CORE
+// No sound, flight recorder or log in the core: their calls in update_game() compile away
+#define play_sound(sound, gain) ((void)0)
+#define flight_event(kind, arg) ((void)0)
+#define log_msg(...)            ((void)0)
+#define prepare_level_async()   prepare_level()     // No threads: title ticks build in line
+#define wait_level()            ((void)0)
+
+// raylib's collision tests, same arithmetic, so the core plays exactly like the game
+static inline bool CheckCollisionCircleRec(Vector2 center, float radius, Rectangle rec)
+{
+    float dx = fabsf(center.x - (rec.x + rec.width/2.0f));
+    float dy = fabsf(center.y - (rec.y + rec.height/2.0f));
+    if (dx > (rec.width/2.0f + radius) || dy > (rec.height/2.0f + radius)) return false;
+    if (dx <= (rec.width/2.0f) || dy <= (rec.height/2.0f)) return true;
+    float cornerDistanceSq = (dx - rec.width/2.0f)*(dx - rec.width/2.0f) + (dy - rec.height/2.0f)*(dy - rec.height/2.0f);
+    return (cornerDistanceSq <= (radius*radius));
+}
+
+static inline bool CheckCollisionRecs(Rectangle rec1, Rectangle rec2)
+{
+    return (rec1.x < (rec2.x + rec2.width) && (rec1.x + rec1.width) > rec2.x) &&
+           (rec1.y < (rec2.y + rec2.height) && (rec1.y + rec1.height) > rec2.y);
+}
+#else
+//------------------------------------------------------------------------------------
+// Main Entry Point
+//------------------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+    startup_mark(STARTUP_MAIN);                              // Startup is timed from here, plus what ran before main()
+    const char *convertList = NULL, *convertOut = NULL;
+    const char *benchList = NULL, *benchBaseline = NULL, *benchOut = NULL, *attractList = NULL;
+    int jobs = 0, shardMB = DATASET_SHARD_MB, evalGames = 0, benchRuns = BENCH_RUNS, wallGames = 0;
+    bool headless = false;
+    for (int i = 1; i < argc; i++)                           // Command line options
+    {
+        if (strcmp(argv[i], "--level") == 0 && i + 1 < argc) levelPath = argv[++i];
+        else if (strcmp(argv[i], "--audio-wav") == 0 && i + 1 < argc) audioWavPath = argv[++i];
+        else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) recordDir = argv[++i];
+        else if (strcmp(argv[i], "--convert-replays") == 0 && i + 2 < argc) { convertList = argv[++i]; convertOut = argv[++i]; }
+        else if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) jobs = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--shard-mb") == 0 && i + 1 < argc) shardMB = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--autopilot") == 0 && i + 1 < argc) autopilotPath = argv[++i];
+        else if (strcmp(argv[i], "--script") == 0 && i + 1 < argc) scriptPath = argv[++i];
+        else if (strcmp(argv[i], "--autopilot-eval") == 0 && i + 1 < argc) evalGames = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--metrics") == 0 && i + 1 < argc) metricsPath = argv[++i];
+        else if (strcmp(argv[i], "--flight-dir") == 0 && i + 1 < argc) flightDir = argv[++i];
+        else if (strcmp(argv[i], "--hitch-ms") == 0 && i + 1 < argc) hitchMs = atof(argv[++i]);
+        else if (strcmp(argv[i], "--log") == 0 && i + 1 < argc) logPath = argv[++i];
+        else if (strcmp(argv[i], "--decode-log") == 0 && i + 1 < argc) return decode_log(argv[++i]);
+        else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc) profilePath = argv[++i];
+        else if (strcmp(argv[i], "--profile-hz") == 0 && i + 1 < argc) profileHz = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--bench") == 0 && i + 1 < argc) benchList = argv[++i];
+        else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) benchBaseline = argv[++i];
+        else if (strcmp(argv[i], "--bench-out") == 0 && i + 1 < argc) benchOut = argv[++i];
+        else if (strcmp(argv[i], "--bench-runs") == 0 && i + 1 < argc) benchRuns = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--attract") == 0 && i + 1 < argc) attractList = argv[++i];
+        else if (strcmp(argv[i], "--wall") == 0 && i + 1 < argc) wallGames = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc) sscanf(argv[++i], "%dx%d", &windowWidth, &windowHeight);
+        else if (strcmp(argv[i], "--font") == 0 && i + 1 < argc) fontPath = argv[++i];
+        else if (strcmp(argv[i], "--tty") == 0 && i + 1 < argc) ttyPath = argv[++i];
+        else if (strcmp(argv[i], "--headless") == 0) headless = true;
+        else if (strcmp(argv[i], "--rewind") == 0) rewindEnabled = true;
+        else if (strcmp(argv[i], "--startup-check") == 0) startupCheck = true;
+        else if (strcmp(argv[i], "--startup-budget") == 0 && i + 1 < argc) startupBudgetMs = atof(argv[++i]);
+        else if (strcmp(argv[i], "--bake-font") == 0 && i + 2 < argc) return bake_font(argv[i + 1], argv[i + 2]);
+    }
+
+    if (autopilotPath != NULL && !load_mlp(&autopilot, autopilotPath))
+    {
+        fprintf(stderr, "autopilot: can't load %s\n", autopilotPath);
+        return 1;
+    }
+    if (scriptPath != NULL && !load_script(&script, scriptPath)) return 1;
+    autopilotOn = (autopilot.layers > 0 || script.length > 0); // Loaded means driving, A toggles it off
+    start_profiler(&argc);                                   // Covers the tools below too; writes its file at exit
+
+    // Tools that run without a window
+    if (convertList != NULL) return convert_replays(convertList, convertOut, jobs, shardMB);
+    if (evalGames > 0) return autopilot_eval(evalGames);
+    if (benchList != NULL) return bench_replays(benchList, benchBaseline, benchOut, benchRuns);
+    if (headless) return run_headless();
+
+    start_startup_worker();                                  // Level, sounds and font files while the window opens
+    SetConfigFlags(FLAG_WINDOW_RESIZABLE);                   // Playfield scales to whatever size the window is
+    InitWindow(windowWidth, windowHeight, "Arkanoid ");      // Creates window
+    startup_mark(STARTUP_WINDOW);
+    
+    // No SetTargetFPS: wait_for_next_frame() paces frames itself so it can sample input while idle
+    srand((unsigned int)time(0));                            // Seeds RNG for randomness
+    load_assets();                                           // Bake background before the first frame (needs the GL context)
+    join_startup_worker();                                   // Level built, sound card (or WAV file) open
+    init_game();                                             // Sets up all variables and objects
+    start_metrics();                                         // Only with --metrics
+    start_flight_recorder();                                 // Only with --flight-dir
+    start_log();                                             // Only with --log
+    if (attractList != NULL) start_attract(attractList);     // Recorded games on an idle title screen
+    if (wallGames > 0) start_wall(wallGames);                // Many games tiled in one window
+    start_tty();                                             // Only with --tty
+    start_rewind();                                          // Only with --rewind
+    startup_mark(STARTUP_READY);
+    simTime = nextFrameTime = lastFrameTime = GetTime();     // Simulation clock starts now
+
+    
+    while (!WindowShouldClose() && !(startupCheck && startupTime[STARTUP_FIRST_FRAME] > 0.0)) // Main game loop; exits when window closes
+    {
+        if (wallCount > 0) update_draw_wall();               // Updates and draws every tile
+        else update_draw_frame();                            // Updates and draws this frame
+    }
+
+    // Call cleanup (if needed)
+    stop_tty();                                              // Puts the terminal's colours and cursor back
+    stop_wall();
+    stop_rewind();
+    stop_metrics();
+    stop_flight_recorder();                                  // Lets a dump in progress finish
+    stop_log();                                              // Writes whatever is still queued
+    stop_attract();
+    close_audio();                                           // Stop the mixer before anything it reads goes away
+    unload_assets();                                         // GPU resources go before the context does
+    CloseWindow();                                           // Close window and terminate
+    return exitCode;                                         // 0 (success) unless --startup-check went over budget
+}
+
+//------------------------------------------------------------------------------------
+// Module Functions - major building blocks
+//------------------------------------------------------------------------------------
+void load_assets(void)
+{
+    // Background gradient: same stripes draw_background() used to emit every frame, drawn once
+    backgroundTex = LoadRenderTexture(screenWidth, screenHeight);
+    BeginTextureMode(backgroundTex);
+    for (int i = 0; i < screenHeight; i += 4)
+    {
+        float t = (float)i / screenHeight;
+        Color top = (Color){ 40, 40, 90, 255 };
+        Color bot = (Color){ 130, 130, 220, 255 };
+        Color mid = (Color){
+            (int)(top.r * (1-t) + bot.r * t),
+            (int)(top.g * (1-t) + bot.g * t),
+            (int)(top.b * (1-t) + bot.b * t),
+            255
+        };
+        DrawRectangle(0, i, screenWidth, 4, mid);              // 4-pixel-thick horizontal stripe
+    }
+    EndTextureMode();
+
+    // SDF font, if one was baked: sharp at every size, and one texture for all text
+    if (FileExists(fontPath))
+    {
+        sdfFont = LoadFont(fontPath);
+        sdfShader = LoadShaderFromMemory(NULL, sdfFragmentShader);
+        if (sdfFont.texture.id > 0 && IsShaderReady(sdfShader)) SetTextureFilter(sdfFont.texture, TEXTURE_FILTER_BILINEAR);
+        else
+        {
+            UnloadFont(sdfFont);
+            UnloadShader(sdfShader);
+            sdfFont = (Font){ 0 };
+        }
+    }
+}
+
+void unload_assets(void)
+{
+    UnloadRenderTexture(backgroundTex);
+    if (sdfFont.texture.id > 0)
+    {
+        UnloadFont(sdfFont);
+        UnloadShader(sdfShader);
+    }
+}
+
+int bake_font(const char *ttfPath, const char *fntPath)
+{
+    // Offline step: distance-field glyphs for ASCII 32..126 packed into a PNG, described by a
+    // BMFont text file (which raylib's LoadFont() reads back, atlas and all)
+    int size = 0;
+    unsigned char *data = LoadFileData(ttfPath, &size);
+    GlyphInfo *glyphs = (data != NULL) ? LoadFontData(data, size, FONT_BAKE_SIZE, NULL, 95, FONT_SDF) : NULL;
+    if (glyphs == NULL)
+    {
+        fprintf(stderr, "font: can't read %s\n", ttfPath);
+        UnloadFileData(data);
+        return 1;
+    }
+    Rectangle *recs = NULL;
+    Image atlas = GenImageFontAtlas(glyphs, &recs, 95, FONT_BAKE_SIZE, 0, 1);
+
+    char pngPath[512];
+    snprintf(pngPath, sizeof(pngPath), "%s", fntPath);
+    char *dot = strrchr(pngPath, '.');
+    if (dot == NULL || strchr(dot, '/') != NULL) dot = pngPath + strlen(pngPath);
+    snprintf(dot, sizeof(pngPath) - (dot - pngPath), ".png");
+    const char *pngName = strrchr(pngPath, '/');
+    pngName = (pngName != NULL) ? pngName + 1 : pngPath;     // .fnt refers to it relative to itself
+
+    FILE *file = fopen(fntPath, "w");
+    bool ok = file != NULL && ExportImage(atlas, pngPath);
+    if (file != NULL)
+    {
+        fprintf(file, "info face=\"Arkanoid SDF\" size=%d\n", FONT_BAKE_SIZE);
+        fprintf(file, "common lineHeight=%d base=%d scaleW=%d scaleH=%d pages=1 packed=0\n",
+                FONT_BAKE_SIZE, FONT_BAKE_SIZE, atlas.width, atlas.height);
+        fprintf(file, "page id=0 file=\"%s\"\n", pngName);
+        fprintf(file, "chars count=95\n");
+        for (int i = 0; i < 95; i++)
+            fprintf(file, "char id=%d x=%d y=%d width=%d height=%d xoffset=%d yoffset=%d xadvance=%d page=0 chnl=15\n",
+                    glyphs[i].value, (int)recs[i].x, (int)recs[i].y, (int)recs[i].width, (int)recs[i].height,
+                    glyphs[i].offsetX, glyphs[i].offsetY, glyphs[i].advanceX);
+        ok = ok && !ferror(file);
+        fclose(file);
+    }
+    if (!ok) fprintf(stderr, "font: can't write %s / %s\n", fntPath, pngPath);
+
+    UnloadImage(atlas);
+    RL_FREE(recs);
+    UnloadFontData(glyphs, 95);
+    UnloadFileData(data);
+    return ok ? 0 : 1;
+}
+
+//------------------------------------------------------------------------------------
+// Startup - timed from process start to the first frame; window-free work runs on a worker
+//------------------------------------------------------------------------------------
+static double startup_clock(void)
+{
+    // GetTime() only starts with the window, and startup is mostly before that
+#ifndef _WIN32
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec*1e-9;
+#else
+    return (double)clock()/CLOCKS_PER_SEC;                  // Wall time since the process started on Windows
+#endif
+}
+
+static double process_age_ms(void)
+{
+    // How long the process ran before main() (loader, shared libraries), from its start time in
+    // /proc, which only has scheduler-tick resolution (usually 10 ms). -1 where unavailable
+#ifdef __linux__
+    FILE *file = fopen("/proc/self/stat", "r");
+    if (file == NULL) return -1.0;
+    char text[1024];
+    size_t n = fread(text, 1, sizeof(text) - 1, file);
+    fclose(file);
+    text[n] = '\0';
+    char *p = strrchr(text, ')');                            // The command name may contain spaces
+    unsigned long long startTicks = 0;
+    if (p == NULL || sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %*u %*u %*d %*d %*d %*d %*d %*d %llu", &startTicks) != 1)
+        return -1.0;
+    struct timespec boot;
+    clock_gettime(CLOCK_BOOTTIME, &boot);
+    return (boot.tv_sec + boot.tv_nsec*1e-9 - (double)startTicks/sysconf(_SC_CLK_TCK))*1e3;
+#else
+    return -1.0;
+#endif
+}
+
+static void prefetch_file(const char *path)
+{
+    // Maps the file with MAP_POPULATE, which reads it all into the page cache, then drops the
+    // mapping: whoever opens it next (raylib, here) reads from memory instead of the disk
+#ifndef _WIN32
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+    {
+#ifdef MAP_POPULATE
+        void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+#else
+        void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+#endif
+        if (map != MAP_FAILED)
+        {
+            madvise(map, st.st_size, MADV_WILLNEED);
+            munmap(map, st.st_size);
+        }
+    }
+    close(fd);
+#else
+    (void)path;
+#endif
+}
+
+static void prefetch_font(void)
+{
+    // The .fnt names its atlas image relative to itself
+    prefetch_file(fontPath);
+    FILE *file = fopen(fontPath, "r");
+    if (file == NULL) return;
+    char line[512], page[256];
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        if (sscanf(line, "page id=%*d file=\"%255[^\"]\"", page) != 1) continue;
+        const char *slash = strrchr(fontPath, '/');
+        int dir = (slash != NULL) ? (int)(slash - fontPath + 1) : 0;
+        char path[512];
+        snprintf(path, sizeof(path), "%.*s%s", dir, fontPath, page);
+        prefetch_file(path);
+        break;
+    }
+    fclose(file);
+}
+
+static void *startup_worker(void *arg)
+{
+    // Everything startup does that doesn't need the window, run while InitWindow() makes it.
+    // The main thread touches none of this until it joins
+    double start = startup_clock();
+    prepare_level();                                         // Level file decode and BVH build
+    init_audio();                                            // Sound synthesis, opening the sound card
+    prefetch_font();                                         // Font files into memory for load_assets()
+    startupWorkerMs = (startup_clock() - start)*1e3;
+    return arg;
+}
+
+void start_startup_worker(void)
+{
+#ifndef _WIN32
+    startupWorkerRunning = pthread_create(&startupThread, NULL, startup_worker, NULL) == 0;
+    if (!startupWorkerRunning) startup_worker(NULL);        // No thread: same work, in line
+#else
+    startup_worker(NULL);
+#endif
+}
+
+void join_startup_worker(void)
+{
+#ifndef _WIN32
+    if (startupWorkerRunning) pthread_join(startupThread, NULL);
+    startupWorkerRunning = false;
+#endif
+}
+
+void startup_mark(t_startup_phase phase)
+{
+    startupTime[phase] = startup_clock();
+    if (phase == STARTUP_MAIN) startupProcessMs = process_age_ms();
+    if (phase != STARTUP_FIRST_FRAME) return;
+
+    double window = (startupTime[STARTUP_WINDOW] - startupTime[STARTUP_MAIN])*1e3;
+    double ready = (startupTime[STARTUP_READY] - startupTime[STARTUP_WINDOW])*1e3;
+    double frame = (startupTime[STARTUP_FIRST_FRAME] - startupTime[STARTUP_READY])*1e3;
+    double total = (startupTime[STARTUP_FIRST_FRAME] - startupTime[STARTUP_MAIN])*1e3 + (startupProcessMs > 0 ? startupProcessMs : 0);
+    log_msg(LOG_STARTUP, (float)startupProcessMs, (float)window, (float)ready, (float)frame);
+    if (!startupCheck) return;
+    printf("startup: process %.0f ms, window %.1f ms, setup %.1f ms, first frame %.1f ms, total %.1f ms (budget %.0f ms)\n",
+           startupProcessMs, window, ready, frame, total, startupBudgetMs);
+    printf("startup: worker %.1f ms alongside the window (level, audio, font prefetch)\n", startupWorkerMs);
+    exitCode = (total > startupBudgetMs) ? 1 : 0;
+    if (exitCode != 0) printf("startup: over budget\n");
+}
+
+#endif // ARKANOID_CORE
+
+//------------------------------------------------------------------------------------
+// Bricks - free-form rectangles with a BVH over them so a ball only looks at nearby bricks
+//------------------------------------------------------------------------------------
+static bool reserve_bricks(int count)
+{
+    // Room for count entries in bricks[] while a level loads (grows by doubling)
+#ifdef ARKANOID_CORE
+    return count <= BRICKS_MAX;
+#else
+    if (count <= bricksCapacity) return true;
+    if (count > BRICKS_MAX) return false;
+    int capacity = (bricksCapacity > 0) ? bricksCapacity : 1024;
+    while (capacity < count) capacity *= 2;
+    t_brick *grown = realloc(bricks, (size_t)capacity*sizeof(t_brick));
+    if (grown == NULL) return false;
+    bricks = grown;
+    bricksCapacity = capacity;
+    return true;
+#endif
+}
+
+static bool size_level_state(void)
+{
+    // Alive mask and both BVHs for exactly bricksCount bricks, once the level is loaded
+#ifdef ARKANOID_CORE
+    return true;
+#else
+    size_t words = (bricksCount + 63)/64, nodes = 2*(size_t)bricksCount + 1;
+    t_brick *fitted = realloc(bricks, (bricksCount > 0 ? bricksCount : 1)*sizeof(t_brick)); // Drop the loader's slack
+    if (fitted != NULL) { bricks = fitted; bricksCapacity = (bricksCount > 0) ? bricksCount : 1; }
+    free(bricksAlive);
+    free(bvh);
+    free(levelBvh);
+    bricksAlive = malloc(words*sizeof(uint64_t));
+    bvh = malloc(nodes*sizeof(t_bvh_node));
+    levelBvh = malloc(nodes*sizeof(t_bvh_node));
+    return bricksAlive != NULL && bvh != NULL && levelBvh != NULL;
+#endif
+}
+
+static int build_default_level(void)
+{
+    // Classic grid: brick size based on screen width and number of bricks per line
+    Vector2 brickSize = { screenWidth/(float)BRICKS_PER_LINE, 38 };
+    int n = 0;
+    if (!reserve_bricks(LINES_OF_BRICKS*BRICKS_PER_LINE)) return 0;
+
+    for (int y = 0; y < LINES_OF_BRICKS; y++)
+    {
+        for (int x = 0; x < BRICKS_PER_LINE; x++)
+        {
+            bricks[n].rect = (Rectangle){
+                x * brickSize.x + 7,                    // X position (with left margin)
+                y * brickSize.y + 70,                   // Y position (with top margin)
+                brickSize.x - 12,                       // Brick width (with padding)
+                brickSize.y - 10                        // Brick height (with padding)
+            };
+            bricks[n].color = (y + x) % 2 ? GRAY : ORANGE;
+            bricks[n].poly = -1;
+            n++;
+        }
+    }
+    return n;
+}
+
+#ifndef ARKANOID_CORE
+static bool reserve_brick_polys(int count)
+{
+    // Room for count entries in brickPolys[] (grows by doubling, like reserve_bricks)
+    if (count <= brickPolysCapacity) return true;
+    int capacity = (brickPolysCapacity > 0) ? 2*brickPolysCapacity : 256;
+    while (capacity < count) capacity *= 2;
+    t_brick_poly *grown = realloc(brickPolys, (size_t)capacity*sizeof(t_brick_poly));
+    if (grown == NULL) return false;
+    brickPolys = grown;
+    brickPolysCapacity = capacity;
+    return true;
+}
+
+static bool add_poly_brick(t_brick *brick, const Vector2 *v, int count)
+{
+    // Checks the shape is convex, puts it in fan order and precomputes its edge planes.
+    // The caller has reserved room for one more polygon
+    if (count < 3 || count > BRICK_POLY_VERTS || brickPolysCount >= brickPolysCapacity) return false;
+    for (int k = 0; k < count; k++)
+        if (!isfinite(v[k].x) || !isfinite(v[k].y)) return false; // Also catches corners that overflowed
+
+    t_brick_poly *p = &brickPolys[brickPolysCount];
+    float area = 0.0f;
+    for (int k = 0; k < count; k++) area += v[k].x*v[(k + 1) % count].y - v[(k + 1) % count].x*v[k].y;
+    if (area == 0.0f) return false;
+    for (int k = 0; k < count; k++) p->v[k] = (area < 0.0f) ? v[k] : v[count - 1 - k]; // Screen CCW has negative area
+    p->count = count;
+
+    Vector2 center = { 0 };
+    for (int k = 0; k < count; k++) { center.x += p->v[k].x/count; center.y += p->v[k].y/count; }
+
+    float minX = INFINITY, minY = INFINITY, maxX = -INFINITY, maxY = -INFINITY;
+    for (int k = 0; k < BRICK_POLY_VERTS; k++)
+    {
+        int e = (k < count) ? k : 0;                     // Spare slots repeat edge 0 so max() is unchanged
+        Vector2 a = p->v[e], b = p->v[(e + 1) % count];
+        float nx = b.y - a.y, ny = a.x - b.x;            // Perpendicular to the edge...
+        float len = sqrtf(nx*nx + ny*ny);
+        if (len == 0.0f) return false;                   // Repeated corner
+        nx /= len; ny /= len;
+        if (nx*(center.x - a.x) + ny*(center.y - a.y) > 0.0f) { nx = -nx; ny = -ny; } // ...facing out
+        p->nx[k] = nx; p->ny[k] = ny;
+        p->d[k] = nx*a.x + ny*a.y;
+        if (k < count)
+        {
+            minX = fminf(minX, a.x); minY = fminf(minY, a.y);
+            maxX = fmaxf(maxX, a.x); maxY = fmaxf(maxY, a.y);
+        }
+    }
+    for (int k = 0; k < count; k++)                      // Convex = every corner behind every edge
+        for (int e = 0; e < count; e++)
+            if (p->nx[e]*p->v[k].x + p->ny[e]*p->v[k].y - p->d[e] > 0.01f) return false;
+
+    brick->rect = (Rectangle){ minX, minY, maxX - minX, maxY - minY };
+    brick->poly = brickPolysCount++;
+    return true;
+}
+
+static int read_numbers(const char *s, float *out, int max)
+{
+    int n = 0;
+    char *end;
+    while (n < max)
+    {
+        float f = strtof(s, &end);
+        if (end == s) break;                             // No more numbers on the line
+        out[n++] = f;
+        s = end;
+    }
+    return n;
+}
+
+static bool all_finite(const float *v, int count)
+{
+    for (int k = 0; k < count; k++) if (!isfinite(v[k])) return false;
+    return true;
+}
+
+static int count_arg(float v, int max)
+{
+    // A count read as a float: out-of-range (or NaN) values become 0 instead of an undefined cast
+    return (v >= 0.0f && v <= (float)max) ? (int)v : 0;
+}
+
+static unsigned char color_arg(float v)
+{
+    return (unsigned char)((v > 0.0f) ? ((v < 255.0f) ? v : 255.0f) : 0.0f);   // Clamped first: NaN and -1 give 0
+}
+
+static int load_level_file(const char *path)
+{
+    // One brick per line, in screen pixels, '#' starts a comment:
+    //   x y width height [r g b]                  plain rectangle
+    //   rot cx cy width height degrees [r g b]    rotated slab
+    //   ngon cx cy radius sides degrees [r g b]   regular polygon (triangle, hexagon, ...)
+    //   poly n x1 y1 ... xn yn [r g b]            any convex polygon, up to BRICK_POLY_VERTS corners
+    FILE *file = fopen(path, "r");
+    if (file == NULL) return 0;
+
+    char line[512];
+    int n = 0;
+    bool refused = false;                                // Set when the level can't be loaded whole
+    while (!refused && fgets(line, sizeof(line), file) != NULL)
+    {
+        float num[2*BRICK_POLY_VERTS + 8];
+        const int maxNum = (int)(sizeof(num)/sizeof(num[0]));
+        Vector2 v[BRICK_POLY_VERTS];
+        int got, colorAt;
+        bool ok = false;
+        t_brick parsed = { .poly = -1 }, *brick = &parsed;
+
+        if (line[0] == '#') continue;
+        if (strncmp(line, "rot", 3) == 0 || strncmp(line, "ngon", 4) == 0 || strncmp(line, "poly", 4) == 0)
+        {
+            if (!reserve_brick_polys(brickPolysCount + 1)) { fprintf(stderr, "level: out of memory loading %s\n", path); refused = true; break; }
+        }
+        if (strncmp(line, "rot", 3) == 0 && (got = read_numbers(line + 3, num, maxNum)) >= 5 && all_finite(num, got))
+        {
+            float c = cosf(num[4]*DEG2RAD), s = sinf(num[4]*DEG2RAD);
+            for (int k = 0; k < 4; k++)
+            {
+                float hx = ((k == 1 || k == 2) ? 0.5f : -0.5f)*num[2], hy = ((k >= 2) ? 0.5f : -0.5f)*num[3];
+                v[k] = (Vector2){ num[0] + hx*c - hy*s, num[1] + hx*s + hy*c };
+            }
+            ok = add_poly_brick(brick, v, 4);
+            colorAt = 5;
+        }
+        else if (strncmp(line, "ngon", 4) == 0 && (got = read_numbers(line + 4, num, maxNum)) >= 5 && all_finite(num, got))
+        {
+            int sides = count_arg(num[3], BRICK_POLY_VERTS);
+            for (int k = 0; k < sides && k < BRICK_POLY_VERTS; k++)
+            {
+                float a = num[4]*DEG2RAD + k*2*PI/sides;
+                v[k] = (Vector2){ num[0] + cosf(a)*num[2], num[1] + sinf(a)*num[2] };
+            }
+            ok = add_poly_brick(brick, v, sides);
+            colorAt = 5;
+        }
+        else if (strncmp(line, "poly", 4) == 0 && (got = read_numbers(line + 4, num, maxNum)) >= 1 && all_finite(num, got))
+        {
+            int count = count_arg(num[0], BRICK_POLY_VERTS);
+            if (count >= 3 && count <= BRICK_POLY_VERTS && got >= 1 + 2*count)
+            {
+                for (int k = 0; k < count; k++) v[k] = (Vector2){ num[1 + 2*k], num[2 + 2*k] };
+                ok = add_poly_brick(brick, v, count);
+            }
+            colorAt = 1 + 2*count;
+        }
+        else if (strncmp(line, "rot", 3) == 0 || strncmp(line, "ngon", 4) == 0 || strncmp(line, "poly", 4) == 0)
+        {
+            continue;                                    // Too few numbers, or an inf/nan among them
+        }
+        else
+        {
+            got = read_numbers(line, num, maxNum);
+            colorAt = 4;
+            if (got < 4 || !all_finite(num, got)) continue; // Blank line, not enough numbers or inf/nan
+            brick->rect = (Rectangle){ num[0], num[1], num[2], num[3] };
+            ok = (num[2] > 0 && num[3] > 0 && isfinite(num[0] + num[2]) && isfinite(num[1] + num[3]));
+        }
+        if (!ok) continue;                               // Blank, broken or non-convex line
+
+        brick->color = (got >= colorAt + 3) ?
+            (Color){ color_arg(num[colorAt]), color_arg(num[colorAt + 1]), color_arg(num[colorAt + 2]), 255 } : ORANGE;
+        if (n + 1 > BRICKS_MAX) { fprintf(stderr, "level: %s has more than %d bricks\n", path, BRICKS_MAX); refused = true; }
+        else if (!reserve_bricks(n + 1)) { fprintf(stderr, "level: out of memory loading %s\n", path); refused = true; }
+        else bricks[n++] = parsed;
+    }
+    fclose(file);
+    if (refused)                                         // Half a level would play as a different one:
+    {                                                    // drop it and fall back to the default grid
+        brickPolysCount = 0;
+        return 0;
+    }
+    return n;
+}
+
+#endif // ARKANOID_CORE
+
+static inline bool circle_hits_box(Vector2 c, float r, float minX, float minY, float maxX, float maxY)
+{
+    float dx = c.x - fminf(fmaxf(c.x, minX), maxX);               // Distance to the closest point of the box
+    float dy = c.y - fminf(fmaxf(c.y, minY), maxY);
+    return dx*dx + dy*dy <= r*r;
+}
+
+static bool poly_contact_normal(Vector2 c, float r, const t_brick_poly *p, int best, float sep, Vector2 *normal)
+{
+    // For a polygon the batched test let through: sep is the largest edge plane distance of
+    // the ball's center, best the edge it belongs to
+    if (sep <= 0.0f)                                     // Center inside: push out through the nearest edge
+    {
+        *normal = (Vector2){ p->nx[best], p->ny[best] };
+        return true;
+    }
+
+    // Center outside but within r of an edge plane: the closest boundary point decides,
+    // which also gets the corner cases right (normal points from the corner to the ball)
+    Vector2 q = c;
+    float bestDist = INFINITY;
+    for (int k = 0; k < p->count; k++)
+    {
+        Vector2 a = p->v[k], b = p->v[(k + 1) % p->count];
+        float ex = b.x - a.x, ey = b.y - a.y;
+        float t = ((c.x - a.x)*ex + (c.y - a.y)*ey) / (ex*ex + ey*ey);
+        t = fminf(fmaxf(t, 0.0f), 1.0f);
+        Vector2 e = { a.x + ex*t, a.y + ey*t };
+        float dist = (c.x - e.x)*(c.x - e.x) + (c.y - e.y)*(c.y - e.y);
+        if (dist < bestDist) { bestDist = dist; q = e; }
+    }
+    if (bestDist > r*r) return false;                    // Near a corner, but not touching it
+    float len = sqrtf(bestDist);
+    *normal = (len > 0.0f) ? (Vector2){ (c.x - q.x)/len, (c.y - q.y)/len } : (Vector2){ p->nx[best], p->ny[best] };
+    return true;
+}
+
+static const int32_t batchLaneBit[BRICK_BATCH] = {     // Lane k's bit, for building hit masks without variable shifts
+    1 << 0, 1 << 1, 1 << 2, 1 << 3, 1 << 4, 1 << 5, 1 << 6, 1 << 7,
+    1 << 8, 1 << 9, 1 << 10, 1 << 11, 1 << 12, 1 << 13, 1 << 14, 1 << 15
+};
+
+static inline uint32_t circle_hits_polys(Vector2 c, float r, const t_poly_batch *batch, float *sep, int32_t *edge)
+{
+    // Separating axis test on every lane at once: each step takes one edge plane of all the
+    // candidates, keeps the largest distance (and which edge it was) per lane, and a lane hits
+    // when no edge separates it by more than r. Fixed trip counts and selects instead of
+    // branches, so the lane loops compile to SIMD compare/blend
+    float best[BRICK_BATCH];
+    int32_t which[BRICK_BATCH], hit[BRICK_BATCH];
+    for (int k = 0; k < BRICK_BATCH; k++)
+    {
+        best[k] = batch->nx[0][k]*c.x + batch->ny[0][k]*c.y - batch->d[0][k];
+        which[k] = 0;
+    }
+    for (int e = 1; e < BRICK_POLY_VERTS; e++)
+        for (int k = 0; k < BRICK_BATCH; k++)
+        {
+            float s = batch->nx[e][k]*c.x + batch->ny[e][k]*c.y - batch->d[e][k];
+            int32_t further = -(int32_t)(s > best[k]);   // All ones where edge e is the new maximum
+            which[k] = (which[k] & ~further) | (e & further);
+            best[k] = (s > best[k]) ? s : best[k];
+        }
+    for (int k = 0; k < BRICK_BATCH; k++)
+    {
+        hit[k] = (best[k] <= r) ? batchLaneBit[k] : 0;
+        sep[k] = best[k];
+        edge[k] = which[k];
+    }
+    uint32_t mask = 0;
+    for (int k = 0; k < BRICK_BATCH; k++) mask |= (uint32_t)hit[k];
+    return mask;
+}
+
+static inline uint32_t circle_hits_boxes(Vector2 c, float r, const t_brick_batch *batch)
+{
+    // Clamped-distance test on every lane with no early outs; each lane's answer is one bit.
+    // Written with plain compares and a bit table (not fminf or a variable shift) so that
+    // compilers turn both loops into SIMD min/max/compare/or
+    int32_t hit[BRICK_BATCH];
+    for (int k = 0; k < BRICK_BATCH; k++)
+    {
+        float qx = (c.x < batch->minX[k]) ? batch->minX[k] : c.x;  // Closest point of box k
+        float qy = (c.y < batch->minY[k]) ? batch->minY[k] : c.y;
+        qx = (qx > batch->maxX[k]) ? batch->maxX[k] : qx;
+        qy = (qy > batch->maxY[k]) ? batch->maxY[k] : qy;
+        float dx = c.x - qx, dy = c.y - qy;
+        hit[k] = (dx*dx + dy*dy <= r*r) ? batchLaneBit[k] : 0;
+    }
+    uint32_t mask = 0;
+    for (int k = 0; k < BRICK_BATCH; k++) mask |= (uint32_t)hit[k];
+    return mask;
+}
+
+static Vector2 rect_contact_normal(Vector2 c, Rectangle rec)
+{
+    float qx = fminf(fmaxf(c.x, rec.x), rec.x + rec.width);  // Closest point of the brick
+    float qy = fminf(fmaxf(c.y, rec.y), rec.y + rec.height);
+    float dx = c.x - qx, dy = c.y - qy, len = sqrtf(dx*dx + dy*dy);
+    if (len > 0.0f) return (Vector2){ dx/len, dy/len };
+
+    // Center inside: out through the nearest side
+    float left = c.x - rec.x, right = rec.x + rec.width - c.x, top = c.y - rec.y, bottom = rec.y + rec.height - c.y;
+    float m = fminf(fminf(left, right), fminf(top, bottom));
+    return (m == left) ? (Vector2){ -1, 0 } : (m == right) ? (Vector2){ 1, 0 } : (m == top) ? (Vector2){ 0, -1 } : (Vector2){ 0, 1 };
+}
+
+static int flush_brick_batch(Vector2 c, float r, t_brick_batch *batch, t_contact *out, int found, int max)
+{
+    for (int k = batch->count; k < BRICK_BATCH; k++)     // Empty boxes in spare lanes never hit
+    {
+        batch->minX[k] = batch->minY[k] = INFINITY;
+        batch->maxX[k] = batch->maxY[k] = -INFINITY;
+    }
+    uint32_t mask = circle_hits_boxes(c, r, batch);
+    for (int k = 0; mask != 0 && k < batch->count && found < max; k++)
+    {
+        if (!((mask >> k) & 1)) continue;
+        out[found].brick = batch->brick[k];
+        out[found].normal = rect_contact_normal(c, bricks[batch->brick[k]].rect);
+        found++;
+    }
+    batch->count = 0;
+    return found;
+}
+
+static int flush_poly_batch(Vector2 c, float r, t_poly_batch *batch, t_contact *out, int found, int max)
+{
+    for (int k = batch->count; k < BRICK_BATCH; k++)     // Spare lanes: edge 0 is infinitely far, never a hit
+    {
+        batch->nx[0][k] = batch->ny[0][k] = 0.0f;
+        batch->d[0][k] = -INFINITY;
+    }
+    float sep[BRICK_BATCH];
+    int32_t edge[BRICK_BATCH];
+    uint32_t mask = circle_hits_polys(c, r, batch, sep, edge);
+    for (int k = 0; mask != 0 && k < batch->count && found < max; k++)
+    {
+        if (!((mask >> k) & 1)) continue;
+        const t_brick_poly *p = &brickPolys[bricks[batch->brick[k]].poly];
+        if (!poly_contact_normal(c, r, p, edge[k], sep[k], &out[found].normal)) continue;
+        out[found++].brick = batch->brick[k];
+    }
+    batch->count = 0;
+    return found;
+}
+
+static void fit_bvh_node(t_bvh_node *node, int first, int count, bool onlyAlive)
+{
+    node->minX = node->minY = INFINITY;
+    node->maxX = node->maxY = -INFINITY;
+    for (int i = first; i < first + count; i++)
+    {
+        if (onlyAlive && !((bricksAlive[i >> 6] >> (i & 63)) & 1)) continue;
+        Rectangle r = bricks[i].rect;
+        node->minX = fminf(node->minX, r.x);
+        node->minY = fminf(node->minY, r.y);
+        node->maxX = fmaxf(node->maxX, r.x + r.width);
+        node->maxY = fmaxf(node->maxY, r.y + r.height);
+    }
+}
+
+static int sah_bin(const Rectangle *r, int axis, float cmin, float extent)
+{
+    float c = axis == 0 ? r->x + r->width/2 : r->y + r->height/2;
+    int bin = (int)((c - cmin) / extent * BVH_SAH_BINS);
+    return bin < 0 ? 0 : (bin >= BVH_SAH_BINS ? BVH_SAH_BINS - 1 : bin);
+}
+
+static void build_bvh_node(int index, int first, int count, int parent, int depth)
+{
+    t_bvh_node *node = &levelBvh[index];
+    node->parent = parent;
+    node->alive = count;
+    fit_bvh_node(node, first, count, false);
+
+    if (count <= BVH_LEAF_BRICKS)                       // Small enough: make a leaf
+    {
+        node->first = first;
+        node->count = count;
+        for (int i = first; i < first + count; i++) bricks[i].leaf = index;
+        return;
+    }
+
+    // Binned SAH: try BVH_SAH_BINS split planes on each axis, keep the one where
+    // (half-perimeter x bricks) summed over both sides is lowest
+    float cmin[2] = { INFINITY, INFINITY }, cmax[2] = { -INFINITY, -INFINITY };
+    for (int i = first; i < first + count; i++)
+    {
+        Rectangle r = bricks[i].rect;
+        cmin[0] = fminf(cmin[0], r.x + r.width/2);  cmax[0] = fmaxf(cmax[0], r.x + r.width/2);
+        cmin[1] = fminf(cmin[1], r.y + r.height/2); cmax[1] = fmaxf(cmax[1], r.y + r.height/2);
+    }
+
+    int bestAxis = -1, bestSplit = 0;
+    float bestCost = INFINITY;
+    for (int axis = 0; axis < 2 && depth < BVH_SAH_DEPTH; axis++)
+    {
+        float extent = cmax[axis] - cmin[axis];
+        if (extent <= 0.0f) continue;                    // All centers on one line, can't split this way
+
+        t_bvh_node bins[BVH_SAH_BINS];
+        int binCount[BVH_SAH_BINS] = { 0 };
+        for (int k = 0; k < BVH_SAH_BINS; k++) fit_bvh_node(&bins[k], 0, 0, false);
+        for (int i = first; i < first + count; i++)
+        {
+            Rectangle r = bricks[i].rect;
+            int k = sah_bin(&r, axis, cmin[axis], extent);
+            binCount[k]++;
+            bins[k].minX = fminf(bins[k].minX, r.x);
+            bins[k].minY = fminf(bins[k].minY, r.y);
+            bins[k].maxX = fmaxf(bins[k].maxX, r.x + r.width);
+            bins[k].maxY = fmaxf(bins[k].maxY, r.y + r.height);
+        }
+
+        // Sweep from the right to get the cost of everything after each plane...
+        float rightCost[BVH_SAH_BINS];
+        t_bvh_node acc = bins[BVH_SAH_BINS - 1];
+        int accCount = binCount[BVH_SAH_BINS - 1];
+        for (int k = BVH_SAH_BINS - 2; k >= 0; k--)
+        {
+            rightCost[k] = accCount ? ((acc.maxX - acc.minX) + (acc.maxY - acc.minY)) * accCount : 0.0f;
+            acc.minX = fminf(acc.minX, bins[k].minX); acc.minY = fminf(acc.minY, bins[k].minY);
+            acc.maxX = fmaxf(acc.maxX, bins[k].maxX); acc.maxY = fmaxf(acc.maxY, bins[k].maxY);
+            accCount += binCount[k];
+        }
+        // ...then from the left, adding the cost of everything before it
+        acc = bins[0];
+        accCount = 0;
+        for (int k = 0; k < BVH_SAH_BINS - 1; k++)
+        {
+            acc.minX = fminf(acc.minX, bins[k].minX); acc.minY = fminf(acc.minY, bins[k].minY);
+            acc.maxX = fmaxf(acc.maxX, bins[k].maxX); acc.maxY = fmaxf(acc.maxY, bins[k].maxY);
+            accCount += binCount[k];
+            if (accCount == 0 || accCount == count) continue;       // Plane doesn't separate anything
+            float cost = ((acc.maxX - acc.minX) + (acc.maxY - acc.minY)) * accCount + rightCost[k];
+            if (cost < bestCost) { bestCost = cost; bestAxis = axis; bestSplit = k; }
+        }
+    }
+
+    int mid = first + count/2;                           // Fallback: just halve the list
+    if (bestAxis >= 0)
+    {
+        // Partition in place: bricks in bins <= bestSplit go left
+        float extent = cmax[bestAxis] - cmin[bestAxis];
+        int i = first, j = first + count - 1;
+        while (i <= j)
+        {
+            if (sah_bin(&bricks[i].rect, bestAxis, cmin[bestAxis], extent) <= bestSplit) i++;
+            else { t_brick tmp = bricks[i]; bricks[i] = bricks[j]; bricks[j] = tmp; j--; }
+        }
+        mid = i;
+    }
+
+    int left = bvhCount;
+    bvhCount += 2;
+    node->first = left;
+    node->count = 0;
+    build_bvh_node(left, first, mid - first, index, depth + 1);
+    build_bvh_node(left + 1, mid, first + count - mid, index, depth + 1);
+}
+
+static void build_level(void)
+{
+    bricksCount = 0;
+    brickPolysCount = 0;
+#ifndef ARKANOID_CORE
+    if (levelPath != NULL) bricksCount = load_level_file(levelPath);
+#endif
+    if (bricksCount == 0) bricksCount = build_default_level();   // No, empty or refused level file: classic grid
+    if (!size_level_state()) bricksCount = brickPolysCount = bvhCount = 0; // Out of memory: an empty field
+    else
+    {
+        bvhCount = 1;                                    // Node 0 is the root
+        build_bvh_node(0, 0, bricksCount, -1, 0);
+    }
+    levelReady = true;
+}
+
+void prepare_level(void)
+{
+    wait_level();
+    if (!levelReady) build_level();                      // Already built: nothing to do
+}
+
+#ifndef ARKANOID_CORE
+static void *level_worker(void *arg)
+{
+    build_level();
+    return arg;
+}
+
+void prepare_level_async(void)
+{
+    // A big level file takes seconds to parse and build; on the title screen that happens on a
+    // thread (the title draws no bricks) and starting a game waits for it in prepare_level()
+#ifndef _WIN32
+    if (levelThreadBusy || levelReady) return;
+    levelThreadBusy = pthread_create(&levelThread, NULL, level_worker, NULL) == 0;
+    if (levelThreadBusy) return;
+#endif
+    prepare_level();                                     // No thread: build it in line
+}
+
+void wait_level(void)
+{
+#ifndef _WIN32
+    if (levelThreadBusy) pthread_join(levelThread, NULL);
+    levelThreadBusy = false;
+#endif
+}
+#endif
+
+static inline bool brick_alive(int i) { return (bricksAlive[i >> 6] >> (i & 63)) & 1; }
+
+static void destroy_brick(int i)
+{
+    bricksAlive[i >> 6] &= ~((uint64_t)1 << (i & 63));
+    bricksLeft--;
+
+    // Walk up to the root: one less brick below each node, and shrink bounds to what's left
+    for (int n = bricks[i].leaf; n >= 0; n = bvh[n].parent)
+    {
+        t_bvh_node *node = &bvh[n];
+        node->alive--;
+        if (node->alive == 0) continue;                  // Pruned, bounds don't matter any more
+        if (node->count > 0) fit_bvh_node(node, node->first, node->count, true);
+        else
+        {
+            const t_bvh_node *l = &bvh[node->first], *r = &bvh[node->first + 1];
+            if (l->alive == 0) l = r;                    // Only one side left standing
+            if (r->alive == 0) r = l;
+            node->minX = fminf(l->minX, r->minX); node->minY = fminf(l->minY, r->minY);
+            node->maxX = fmaxf(l->maxX, r->maxX); node->maxY = fmaxf(l->maxY, r->maxY);
+        }
+    }
+}
+
+static int find_brick_contacts(Vector2 center, float radius, t_contact *out, int max)
+{
+    int stack[BVH_STACK_SIZE];
+    int top = 0, found = 0;
+    t_brick_batch batch;
+    t_poly_batch polys;
+    batch.count = polys.count = 0;
+
+    if (bvhCount > 0) stack[top++] = 0;
+    while (top > 0)
+    {
+        const t_bvh_node *node = &bvh[stack[--top]];
+        if (node->alive == 0 || !circle_hits_box(center, radius, node->minX, node->minY, node->maxX, node->maxY))
+            continue;                                    // Nothing standing here, or ball nowhere near
+        if (node->count == 0)
+        {
+            stack[top++] = node->first;
+            stack[top++] = node->first + 1;
+            continue;
+        }
+        for (int i = node->first; i < node->first + node->count; i++)
+        {
+            if (!brick_alive(i)) continue;
+            if (bricks[i].poly < 0)                      // Rectangles queue up for the batched test
+            {
+                Rectangle rec = bricks[i].rect;
+                batch.minX[batch.count] = rec.x;
+                batch.minY[batch.count] = rec.y;
+                batch.maxX[batch.count] = rec.x + rec.width;
+                batch.maxY[batch.count] = rec.y + rec.height;
+                batch.brick[batch.count++] = i;
+                if (batch.count == BRICK_BATCH) found = flush_brick_batch(center, radius, &batch, out, found, max);
+            }
+            else                                         // So do polygons, planes copied into their lane
+            {
+                const t_brick_poly *p = &brickPolys[bricks[i].poly];
+                for (int e = 0; e < BRICK_POLY_VERTS; e++)
+                {
+                    polys.nx[e][polys.count] = p->nx[e];
+                    polys.ny[e][polys.count] = p->ny[e];
+                    polys.d[e][polys.count] = p->d[e];
+                }
+                polys.brick[polys.count++] = i;
+                if (polys.count == BRICK_BATCH) found = flush_poly_batch(center, radius, &polys, out, found, max);
+            }
+            if (found == max) return found;
+        }
+    }
+    if (batch.count > 0) found = flush_brick_batch(center, radius, &batch, out, found, max);
+    if (polys.count > 0 && found < max) found = flush_poly_batch(center, radius, &polys, out, found, max);
+    return found;
+}
+
+void init_game(void)
+{
+    prepare_level();             // No-op when the title screen already built it
+    rngState = gameSeed ? gameSeed : 0x9E3779B9u;                // Same seed, same game (xorshift can't start at 0)
+
+    // Initialize player (paddle)
+    player.size = (Vector2){ 140, 22 };                          // Paddle width/height
+    player.pos = (Vector2){ screenWidth/2.0f - player.size.x/2, screenHeight - 50 }; // Center & offset paddle near bottom
+    player.life = PLAYER_MAX_LIFE;                               // Set lives to max value
+    player.speed = 15.0f;                                         // Set left/right paddle movement speed
+    player.expanded = false;                                     // Not expanded at start
+    player.expand_timer = 0.0f;                                  // No expansion timer at start
+
+    // Initialize balls
+    for (int i = 0; i < BALLS_MAX; i++) balls[i].active = false; // All balls inactive at first
+    ballsCount = 1;                                              // Start with only 1 ball available
+    balls[0].radius = 12;                                        // Standard ball size
+    balls[0].pos = (Vector2){ player.pos.x + player.size.x/2, player.pos.y - balls[0].radius - 2 }; // Ball starts above paddle
+    balls[0].spd = (Vector2){ 0, 0 };                            // Ball doesn't move until launched
+    balls[0].active = false;                                     // Ball at rest initially
+
+    // Initialize bricks from the prepared layout (plain copies, so starting a game is instant)
+    memcpy(bvh, levelBvh, bvhCount * sizeof(t_bvh_node));
+    int words = (bricksCount + 63)/64;                           // Alive mask: exactly the level's bricks
+    for (int i = 0; i < words; i++) bricksAlive[i] = ~(uint64_t)0;
+    if (bricksCount % 64) bricksAlive[words - 1] = ((uint64_t)1 << (bricksCount % 64)) - 1;
+    bricksLeft = bricksCount;                                    // Mark all bricks as visible and undestroyed
+
+    // Initialize powerups
+    for (int i = 0; i < POWERUPS_MAX; i++) powerups[i].active = false; // All powerups start inactive
+#ifndef ARKANOID_CORE
+    memset(script.regs + SCRIPT_VAR_BASE, 0, SCRIPT_VARS*sizeof(float)); // Bot script variables start at 0
+#endif
+
+    score = 0;                   // Reset score
+    paused = false;              // Unpause if previously paused
+    waiting_for_launch = true;   // Ball ready to be launched (space bar)
+}
+
+void spawn_powerup(Vector2 pos)
+{
+    t_powerup_type type = POWERUP_NONE;                 // Default powerup type
+    int r = game_random(0, 99);                         // Get random value 0-99
+    if (r < 40) type = POWERUP_EXPAND;
+    else if (r < 70) type = POWERUP_EXTRA_LIFE;
+    else type = POWERUP_MULTI_BALL;
+    for (int i = 0; i < POWERUPS_MAX; i++) {            // Find a slot for new powerup
+        if (!powerups[i].active) {                      // Only spawn if inactive
+            powerups[i].pos = pos;                      // Set position
+            powerups[i].spd = (Vector2){0, 2};          // Fall straight down at speed 2
+            powerups[i].type = type;                    // Set powerup type
+            powerups[i].active = true;                  // Mark as active/visible
+            break;
+        }
+    }
+}
+
+void apply_powerup(t_powerup_type type)
+{
+    switch (type) {
+        case POWERUP_EXPAND:                             // Expand paddle powerup
+            player.expanded = true;
+            player.expand_timer = 10.0f;                 // Lasts 10 seconds
+            player.size.x = 210;                         // Increase paddle width
+            break;
+        case POWERUP_EXTRA_LIFE:                         // Extra life powerup
+            player.life += 1;                            // Give one more life
+            break;
+        case POWERUP_MULTI_BALL:                         // Multi-ball powerup
+            for (int i = 0; i < BALLS_MAX && ballsCount < 3; i++) {
+                if (balls[i].active) {                   // For every active ball
+                    for (int j = 0; j < BALLS_MAX; j++) {
+                        if (!balls[j].active) {          // Find an inactive slot
+                            balls[j] = balls[i];         // Clone ball properties
+                            balls[j].spd.x *= -1;        // Reverse ball's X to split
+                            balls[j].spd.y *= (game_random(0, 1) == 0) ? 1 : -1; // Randomize split direction
+                            balls[j].active = true;
+                            ballsCount++;                // Increase ball count
+                            break;
+                        }
+                    }
+                }
+            }
+            break;
+        default: break;                                  // If no powerup, do nothing
+    }
+}
+
+void reset_balls(Vector2 pos)
+{
+    for (int i = 0; i < BALLS_MAX; i++) balls[i].active = false; // Deactivate all balls
+    ballsCount = 1;                      // Only have one ball after reset
+    balls[0].radius = 12;                // Standard size
+    balls[0].pos = pos;                  // Place at given position
+    balls[0].spd = (Vector2){ 0, 0 };    // Ball at rest
+    balls[0].active = false;             // Wait for launch
+}
+
+static inline bool input_down(t_input_key key) { return (input.down >> key) & 1; }
+static inline bool input_pressed(t_input_key key) { return (input.pressed >> key) & 1; }
+
+#ifndef ARKANOID_CORE
+static void push_input_event(double time, t_input_key key, bool down)
+{
+    if (inputHead - inputTail >= INPUT_QUEUE_SIZE) return;     // Queue full (no tick ran for ages), drop
+    inputQueue[inputHead & (INPUT_QUEUE_SIZE - 1)] = (t_input_event){ time, key, down };
+    inputHead++;
+}
+
+void poll_input(void)
+{
+    double now = GetTime();
+
+    // raylib's press queue also holds keys that went down and up again since the last poll,
+    // which IsKeyDown() alone would never see
+    unsigned int tapped = 0;
+    for (int k = GetKeyPressed(); k != 0; k = GetKeyPressed())
+    {
+        for (int i = 0; i < INPUT_KEY_COUNT; i++)
+            if (inputKeyMap[i] == k) tapped |= 1u << i;
+        for (int i = 0; i < REWIND_KEY_COUNT && rewindSnaps != NULL; i++)   // Not game input: never recorded
+            if (rewindKeyMap[i] == k) rewindKeys |= 1u << i;
+    }
+
+    for (int i = 0; i < INPUT_KEY_COUNT; i++)
+    {
+        unsigned int bit = 1u << i;
+        bool down = IsKeyDown(inputKeyMap[i]);
+        bool wasDown = inputSampled & bit;
+
+        if (down != wasDown)
+            push_input_event(now, (t_input_key)i, down);          // Ordinary press or release
+        else if (tapped & bit)
+        {
+            // Tap finished between samples (or released and pressed again): record both edges
+            push_input_event(now, (t_input_key)i, !down);
+            push_input_event(now, (t_input_key)i, down);
+        }
+        if (down) inputSampled |= bit; else inputSampled &= ~bit;
+    }
+}
+
+void consume_input(double tickEnd)
+{
+    input.pressed = 0;                                         // Presses only last one tick
+    input.down &= ~inputTapped;                                // So do taps of the movement keys
+    while (inputTail != inputHead)
+    {
+        t_input_event *ev = &inputQueue[inputTail & (INPUT_QUEUE_SIZE - 1)];
+        if (ev->time > tickEnd) break;                         // Belongs to a later tick
+        unsigned int bit = 1u << ev->key;
+        if (ev->down)
+        {
+            input.down |= bit;
+            input.pressed |= bit;
+        }
+        else input.down &= ~bit;     // A press released within the tick still counts as pressed
+        inputTail++;
+    }
+    // ...and a movement key released within the tick still moves the paddle for this tick
+    inputTapped = input.pressed & ~input.down & ((1u << INPUT_LEFT) | (1u << INPUT_RIGHT));
+    input.down |= inputTapped;
+}
+
+void wait_for_next_frame(void)
+{
+    double now = GetTime();
+    nextFrameTime += 1.0/TARGET_FPS;
+    if (nextFrameTime < now) nextFrameTime = now;              // Running late: don't try to catch up
+
+    poll_input();                                              // EndDrawing() just polled events
+    while ((now = GetTime()) < nextFrameTime)
+    {
+        double slice = nextFrameTime - now;
+        if (slice > 1.0/INPUT_POLL_HZ) slice = 1.0/INPUT_POLL_HZ;
+        WaitTime(slice);
+        PollInputEvents();                                     // Ask the OS for new key events
+        poll_input();
+    }
+}
+
+//------------------------------------------------------------------------------------
+// Audio - small software mixer: a fixed voice pool fed through a lock-free request queue
+//------------------------------------------------------------------------------------
+static void make_sound(t_sound sound, float seconds, float freqStart, float freqEnd, bool square)
+{
+    // Tone sweeping from freqStart to freqEnd with a fast attack and exponential decay
+    int frames = (int)(seconds*AUDIO_SAMPLE_RATE);
+    if (frames > SOUND_MAX_FRAMES) frames = SOUND_MAX_FRAMES;
+    float phase = 0.0f;
+    for (int i = 0; i < frames; i++)
+    {
+        float t = (float)i/frames;
+        float freq = freqStart + (freqEnd - freqStart)*t;
+        phase += freq/AUDIO_SAMPLE_RATE;
+        phase -= (int)phase;
+        float wave = square ? (phase < 0.5f ? 1.0f : -1.0f) : sinf(2*PI*phase);
+        float env = fminf(1.0f, i/64.0f)*expf(-4.0f*t);
+        soundPcm[sound][i] = 0.5f*wave*env;
+    }
+    soundLength[sound] = frames;
+}
+
+static void start_voice(t_sound_cmd cmd)
+{
+    // Free voice if there is one, otherwise the one that has played longest
+    int pick = 0;
+    for (int v = 0; v < AUDIO_VOICES; v++)
+    {
+        if (voices[v].pcm == NULL) { pick = v; break; }
+        if (voices[v].pos > voices[pick].pos) pick = v;
+    }
+    voices[pick] = (t_voice){ soundPcm[cmd.sound], soundLength[cmd.sound], 0, cmd.gain };
+}
+
+static void mix_audio(float *restrict out, unsigned int frames)
+{
+    // Runs on the mixer's thread: take new requests, then sum every playing voice into out
+    unsigned int head = ATOMIC_LOAD(&soundHead);
+    while (soundTail != head)
+    {
+        start_voice(soundQueue[soundTail & (AUDIO_QUEUE_SIZE - 1)]);
+        ATOMIC_STORE(&soundTail, soundTail + 1);
+    }
+
+    memset(out, 0, frames*sizeof(float));
+    for (int v = 0; v < AUDIO_VOICES; v++)
+    {
+        t_voice *voice = &voices[v];
+        if (voice->pcm == NULL) continue;
+        int n = voice->length - voice->pos;
+        if (n > (int)frames) n = (int)frames;
+        const float *restrict src = voice->pcm + voice->pos;
+        float gain = voice->gain;
+        int i = 0;
+        for (; i + 8 <= n; i += 8)                           // Blocks of 8: compilers emit SIMD multiply-adds
+            for (int k = 0; k < 8; k++) out[i + k] += src[i + k]*gain;
+        for (; i < n; i++) out[i] += src[i]*gain;
+        voice->pos += n;
+        if (voice->pos >= voice->length) voice->pcm = NULL;
+    }
+    for (unsigned int i = 0; i < frames; i++)                // Hard clip many overlapping voices
+        out[i] = (out[i] > 1.0f) ? 1.0f : ((out[i] < -1.0f) ? -1.0f : out[i]);
+}
+
+static void audio_callback(void *buffer, unsigned int frames)
+{
+    mix_audio((float *)buffer, frames);                     // Called by raylib on its audio thread
+}
+
+static void write_wav_header(FILE *file, unsigned int frames)
+{
+    // 16-bit mono PCM; sizes are patched again when the file is closed
+    unsigned int dataBytes = frames*2;
+    unsigned char h[44] = { 'R','I','F','F', 0,0,0,0, 'W','A','V','E', 'f','m','t',' ', 16,0,0,0, 1,0, 1,0,
+                            0,0,0,0, 0,0,0,0, 2,0, 16,0, 'd','a','t','a', 0,0,0,0 };
+    unsigned int fields[4][2] = { { 4, 36 + dataBytes }, { 24, AUDIO_SAMPLE_RATE }, { 28, AUDIO_SAMPLE_RATE*2 }, { 40, dataBytes } };
+    for (int f = 0; f < 4; f++)
+        for (int b = 0; b < 4; b++) h[fields[f][0] + b] = (unsigned char)(fields[f][1] >> (8*b));
+    fseek(file, 0, SEEK_SET);
+    fwrite(h, 1, sizeof(h), file);
+    fseek(file, 0, SEEK_END);
+}
+
+void init_audio(void)
+{
+    make_sound(SOUND_PADDLE, 0.06f, 440.0f, 440.0f, true);
+    make_sound(SOUND_BRICK, 0.09f, 880.0f, 660.0f, false);
+    make_sound(SOUND_POWERUP, 0.30f, 520.0f, 1040.0f, false);
+    make_sound(SOUND_BALL_LOST, 0.45f, 400.0f, 90.0f, true);
+
+    if (audioWavPath != NULL)
+    {
+        audioWav = fopen(audioWavPath, "wb");
+        if (audioWav != NULL)
+        {
+            write_wav_header(audioWav, 0);
+            audioBackend = AUDIO_WAV;
+        }
+        return;                                             // Offline: never touch the sound card
+    }
+
+    InitAudioDevice();
+    if (!IsAudioDeviceReady()) return;                      // No sound card: stay silent (AUDIO_NULL)
+    SetAudioStreamBufferSizeDefault(AUDIO_BUFFER_FRAMES);
+    audioStream = LoadAudioStream(AUDIO_SAMPLE_RATE, 32, 1);
+    SetAudioStreamCallback(audioStream, audio_callback);
+    PlayAudioStream(audioStream);
+    audioBackend = AUDIO_DEVICE;
+}
+
+void close_audio(void)
+{
+    if (audioBackend == AUDIO_DEVICE)
+    {
+        StopAudioStream(audioStream);
+        UnloadAudioStream(audioStream);
+        CloseAudioDevice();
+    }
+    else if (audioBackend == AUDIO_WAV)
+    {
+        write_wav_header(audioWav, audioWavFrames);
+        fclose(audioWav);
+        audioWav = NULL;
+    }
+    audioBackend = AUDIO_NULL;
+}
+
+void play_sound(t_sound sound, float gain)
+{
+    if (audioBackend == AUDIO_NULL || soundMuted) return;  // Nobody would ever take it off the queue
+    unsigned int tail = ATOMIC_LOAD(&soundTail);
+    if (soundHead - tail >= AUDIO_QUEUE_SIZE) return;       // Mixer is behind; dropping a blip is fine
+    soundQueue[soundHead & (AUDIO_QUEUE_SIZE - 1)] = (t_sound_cmd){ sound, gain };
+    ATOMIC_STORE(&soundHead, soundHead + 1);
+}
+
+void render_audio_tick(void)
+{
+    // WAV backend: exactly one tick of audio per simulation tick, so the file lines up with the game
+    if (audioBackend != AUDIO_WAV) return;
+    float mix[AUDIO_SAMPLE_RATE/TICK_RATE];
+    short pcm[AUDIO_SAMPLE_RATE/TICK_RATE];
+    const unsigned int frames = AUDIO_SAMPLE_RATE/TICK_RATE;
+    mix_audio(mix, frames);
+    for (unsigned int i = 0; i < frames; i++) pcm[i] = (short)(mix[i]*32767.0f);
+    audioWavFrames += (unsigned int)fwrite(pcm, sizeof(short), frames, audioWav);
+}
+
+#endif // ARKANOID_CORE
+
+//------------------------------------------------------------------------------------
+// Replays - record a game as seed + inputs, and play it back without a window
+//------------------------------------------------------------------------------------
+int game_random(int min, int max)
+{
+    rngState ^= rngState << 13;                             // xorshift32: tiny, fast, same everywhere
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return min + (int)(rngState % (uint32_t)(max - min + 1));
+}
+
+#ifndef ARKANOID_CORE
+static void begin_replay(void)
+{
+    if (recordDir == NULL) return;
+    if (levelPath != NULL && strlen(levelPath) >= REPLAY_LEVEL_CHARS)
+    {
+        // Cut short it would name some other file, and the replay would play back on the wrong level
+        fprintf(stderr, "replay: level path longer than %d characters, not recording\n", REPLAY_LEVEL_CHARS - 1);
+        recordDir = NULL;
+        return;
+    }
+    memset(&replayHeader, 0, sizeof(replayHeader));
+    memcpy(replayHeader.magic, "ARKR", 4);
+    replayHeader.version = REPLAY_VERSION;
+    replayHeader.seed = gameSeed;
+    if (levelPath != NULL) strcpy(replayHeader.level, levelPath);
+    recording = true;
+}
+
+static void finish_replay(void)
+{
+    if (!recording) return;
+    recording = false;
+
+    char path[512];
+    snprintf(path, sizeof(path), "%s/replay-%ld-%08x.rpl", recordDir, (long)time(NULL), (unsigned int)replayHeader.seed);
+    FILE *file = fopen(path, "wb");
+    if (file == NULL)
+    {
+        fprintf(stderr, "replay: can't write %s\n", path);
+        return;
+    }
+    fwrite(&replayHeader, sizeof(replayHeader), 1, file);
+    fwrite(replayInputs, sizeof(uint16_t), replayHeader.ticks, file);
+    fclose(file);
+}
+
+void step_game(void)
+{
+    t_gamestate before = gameState;
+    if (recording && replayHeader.ticks < REPLAY_MAX_TICKS)      // Input this tick runs with
+        replayInputs[replayHeader.ticks++] = (uint16_t)(input.down | (input.pressed << 8));
+
+    update_game();
+
+    if (gameState != before) flight_event(FLIGHT_STATE, gameState);
+    if (before == GAME_PLAYING && (gameState == GAME_OVER || gameState == GAME_WIN)) log_msg(LOG_GAME_END, gameState, score);
+    if (before == GAME_TITLE && gameState == GAME_PLAYING) begin_replay();
+    else if (before == GAME_PLAYING && gameState != GAME_PLAYING) finish_replay();
+    rewind_record(before);
+}
+
+bool load_replay(const char *path, t_replay_header *header, uint16_t *inputs)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) return false;
+    bool ok = fread(header, sizeof(*header), 1, file) == 1 &&
+              memcmp(header->magic, "ARKR", 4) == 0 && header->version == REPLAY_VERSION &&
+              header->ticks <= REPLAY_MAX_TICKS &&
+              fread(inputs, sizeof(uint16_t), header->ticks, file) == header->ticks;
+    header->level[REPLAY_LEVEL_CHARS - 1] = '\0';
+    fclose(file);
+    return ok;
+}
+
+void start_replay_game(const t_replay_header *header)
+{
+    // Only rebuild the level when it differs from the one already loaded
+    const char *current = (levelPath != NULL) ? levelPath : "";
+    wait_level();
+    if (!levelReady || strcmp(current, header->level) != 0)
+    {
+        strcpy(replayLevel, header->level);
+        levelPath = (replayLevel[0] != '\0') ? replayLevel : NULL;
+        levelReady = false;
+    }
+    gameSeed = header->seed;
+    init_game();
+    gameState = GAME_PLAYING;
+}
+
+static void extract_features(float *f)
+{
+    // Snapshot of what a player sees, for learning from recorded play
+    int lowest = 0;
+    for (int b = 0; b < BALLS_MAX; b++)
+        if (balls[b].active && (!balls[lowest].active || balls[b].pos.y > balls[lowest].pos.y)) lowest = b;
+    int active = 0;
+    for (int b = 0; b < BALLS_MAX; b++) active += balls[b].active;
+    int pu = -1;
+    for (int i = 0; i < POWERUPS_MAX; i++)
+        if (powerups[i].active && (pu < 0 || powerups[i].pos.y > powerups[pu].pos.y)) pu = i;
+
+    f[FEATURE_PADDLE_X] = player.pos.x + player.size.x/2;
+    f[FEATURE_PADDLE_W] = player.size.x;
+    f[FEATURE_BALL_X] = balls[lowest].pos.x;
+    f[FEATURE_BALL_Y] = balls[lowest].pos.y;
+    f[FEATURE_BALL_VX] = balls[lowest].spd.x;
+    f[FEATURE_BALL_VY] = balls[lowest].spd.y;
+    f[FEATURE_BALLS] = (float)active;
+    f[FEATURE_BRICKS_LEFT] = (float)bricksLeft;
+    f[FEATURE_LIVES] = (float)player.life;
+    f[FEATURE_POWERUP_X] = (pu >= 0) ? powerups[pu].pos.x : -1.0f;
+    f[FEATURE_POWERUP_Y] = (pu >= 0) ? powerups[pu].pos.y : -1.0f;
+}
+
+//------------------------------------------------------------------------------------
+// Dataset converter - replays in, (state features, action) columns out
+//------------------------------------------------------------------------------------
+static bool write_dataset_shard(const t_dataset *ds, const char *path)
+{
+    // Layout: "ARKD" + version/rows/columns (16 bytes), one 32-byte entry per column
+    // (name, type 0=f32 1=u32 2=u8, byte offset), then each column packed on a 64-byte
+    // boundary, so training code can mmap the file and point straight at a column
+    enum { COLUMNS = FEATURE_COUNT + 3 };
+    const void *data[COLUMNS];
+    const char *names[COLUMNS];
+    uint32_t types[COLUMNS], sizes[COLUMNS] = { 0 };
+    for (int c = 0; c < FEATURE_COUNT; c++) { data[c] = ds->features[c]; names[c] = featureNames[c]; types[c] = 0; sizes[c] = 4; }
+    data[FEATURE_COUNT] = ds->action;       names[FEATURE_COUNT] = "action";      types[FEATURE_COUNT] = 2;     sizes[FEATURE_COUNT] = 1;
+    data[FEATURE_COUNT + 1] = ds->replay;   names[FEATURE_COUNT + 1] = "replay";  types[FEATURE_COUNT + 1] = 1; sizes[FEATURE_COUNT + 1] = 4;
+    data[FEATURE_COUNT + 2] = ds->tick;     names[FEATURE_COUNT + 2] = "tick";    types[FEATURE_COUNT + 2] = 1; sizes[FEATURE_COUNT + 2] = 4;
+
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) return false;
+
+    uint32_t head[4] = { 0, 1, ds->rows, COLUMNS };
+    memcpy(head, "ARKD", 4);
+    fwrite(head, sizeof(head), 1, file);
+    uint64_t offset = (16 + 32*COLUMNS + 63) & ~(uint64_t)63;
+    uint64_t offsets[COLUMNS];
+    for (int c = 0; c < COLUMNS; c++)
+    {
+        char entry[32] = { 0 };
+        strncpy(entry, names[c], 19);
+        memcpy(entry + 20, &types[c], 4);
+        memcpy(entry + 24, &offset, 8);
+        fwrite(entry, sizeof(entry), 1, file);
+        offsets[c] = offset;
+        offset = (offset + (uint64_t)ds->rows*sizes[c] + 63) & ~(uint64_t)63;
+    }
+    static const char zeros[64] = { 0 };
+    for (int c = 0; c < COLUMNS; c++)
+    {
+        long pad = (long)offsets[c] - ftell(file);          // Up to the column's 64-byte boundary
+        fwrite(zeros, 1, (size_t)pad, file);
+        fwrite(data[c], sizes[c], ds->rows, file);
+    }
+    bool ok = !ferror(file);
+    fclose(file);
+    return ok;
+}
+
+static void free_dataset(t_dataset *ds)
+{
+    for (int c = 0; c < FEATURE_COUNT; c++) free(ds->features[c]);
+    free(ds->action);
+    free(ds->replay);
+    free(ds->tick);
+}
+
+static int convert_worker(int worker, int jobs, char **paths, int count, const char *outPrefix, uint32_t shardRows)
+{
+    // Re-simulates every jobs-th replay, starting at `worker`, into its own series of shards.
+    // Returns the worker's exit status: 1 if a replay was skipped or a shard couldn't be written
+    t_dataset ds = { 0 };
+    ds.capacity = shardRows;
+    bool allocated = true;
+    for (int c = 0; c < FEATURE_COUNT; c++) allocated &= (ds.features[c] = malloc((size_t)shardRows*sizeof(float))) != NULL;
+    allocated &= (ds.action = malloc(shardRows)) != NULL;
+    allocated &= (ds.replay = malloc((size_t)shardRows*sizeof(uint32_t))) != NULL;
+    allocated &= (ds.tick = malloc((size_t)shardRows*sizeof(uint32_t))) != NULL;
+    if (!allocated)
+    {
+        fprintf(stderr, "convert: worker %d: out of memory for a %u-row shard (try a smaller --shard-mb)\n", worker, shardRows);
+        free_dataset(&ds);
+        return 1;
+    }
+
+    t_replay_header header;
+    int shards = 0, replays = 0, status = 0;
+    uint64_t rowsTotal = 0;
+    char path[512];
+    float f[FEATURE_COUNT];
+
+    for (int r = worker; r < count; r += jobs)
+    {
+        if (!load_replay(paths[r], &header, replayInputs))
+        {
+            fprintf(stderr, "convert: skipping %s (missing, truncated or old version)\n", paths[r]);
+            status = 1;
+            continue;
+        }
+        start_replay_game(&header);
+        for (uint32_t t = 0; t < header.ticks && gameState == GAME_PLAYING; t++)
+        {
+            input.down = replayInputs[t] & 0xff;
+            input.pressed = replayInputs[t] >> 8;
+            if (!paused)                                    // Paused ticks teach nothing
+            {
+                extract_features(f);
+                for (int c = 0; c < FEATURE_COUNT; c++) ds.features[c][ds.rows] = f[c];
+                ds.action[ds.rows] = (uint8_t)(input_down(INPUT_LEFT) | input_down(INPUT_RIGHT) << 1 | input_pressed(INPUT_LAUNCH) << 2);
+                ds.replay[ds.rows] = (uint32_t)r;
+                ds.tick[ds.rows] = t;
+                ds.rows++;
+            }
+            update_game();
+
+            if (ds.rows == ds.capacity)                     // Shard full: write it out, start the next
+            {
+                snprintf(path, sizeof(path), "%s-%02d-%04d.arkd", outPrefix, worker, shards++);
+                if (!write_dataset_shard(&ds, path)) { fprintf(stderr, "convert: can't write %s\n", path); status = 1; }
+                rowsTotal += ds.rows;
+                ds.rows = 0;
+            }
+        }
+        replays++;
+    }
+    if (ds.rows > 0)
+    {
+        snprintf(path, sizeof(path), "%s-%02d-%04d.arkd", outPrefix, worker, shards++);
+        if (!write_dataset_shard(&ds, path)) { fprintf(stderr, "convert: can't write %s\n", path); status = 1; }
+        rowsTotal += ds.rows;
+    }
+    printf("convert: worker %d: %d replays, %llu rows, %d shards\n", worker, replays, (unsigned long long)rowsTotal, shards);
+
+    free_dataset(&ds);
+    return status;
+}
+
+static char **read_replay_list(const char *listPath, int *count)
+{
+    // List file: one replay path per line
+    FILE *list = fopen(listPath, "r");
+    if (list == NULL) return NULL;
+    char **paths = NULL;
+    int cap = 0;
+    char line[1024];
+    *count = 0;
+    while (fgets(line, sizeof(line), list) != NULL)
+    {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '\0') continue;
+        if (*count == cap)
+        {
+            cap = cap ? cap*2 : 1024;
+            paths = realloc(paths, cap*sizeof(char *));
+        }
+        paths[*count] = malloc(strlen(line) + 1);
+        strcpy(paths[(*count)++], line);
+    }
+    fclose(list);
+    if (paths == NULL) paths = malloc(sizeof(char *));      // Empty list is still a list
+    return paths;
+}
+
+int convert_replays(const char *listPath, const char *outPrefix, int jobs, int shardMB)
+{
+    int count;
+    char **paths = read_replay_list(listPath, &count);
+    if (paths == NULL)
+    {
+        fprintf(stderr, "convert: can't open %s\n", listPath);
+        return 1;
+    }
+
+    if (shardMB <= 0) shardMB = DATASET_SHARD_MB;
+    if (shardMB > DATASET_SHARD_MB_MAX)
+    {
+        fprintf(stderr, "convert: --shard-mb %d is too big, using %d\n", shardMB, DATASET_SHARD_MB_MAX);
+        shardMB = DATASET_SHARD_MB_MAX;
+    }
+    uint32_t rowBytes = FEATURE_COUNT*sizeof(float) + 1 + 2*sizeof(uint32_t);
+    uint32_t shardRows = (uint32_t)(((uint64_t)shardMB << 20)/rowBytes);
+
+    int failed = 0;
+#ifndef _WIN32
+    // One process per core: the game state is plain globals, so each fork gets its own copy for free
+    if (jobs <= 0) jobs = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (jobs > count) jobs = count;
+    if (jobs < 1) jobs = 1;
+    for (int w = 0; w < jobs; w++)
+    {
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            int status = convert_worker(w, jobs, paths, count, outPrefix, shardRows);
+            fflush(stdout);
+            _exit(status);
+        }
+        if (pid < 0) failed |= convert_worker(w, jobs, paths, count, outPrefix, shardRows);   // Couldn't fork: do it here
+    }
+    int status;
+    while (wait(&status) > 0) failed |= !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+#else
+    jobs = 1;
+    failed = convert_worker(0, 1, paths, count, outPrefix, shardRows);
+#endif
+
+    for (int i = 0; i < count; i++) free(paths[i]);
+    free(paths);
+    return failed;
+}
+
+//------------------------------------------------------------------------------------
+// Benchmark - times recorded games tick by tick and frame by frame against a baseline
+//------------------------------------------------------------------------------------
+typedef struct s_bench_stats
+{
+    char name[64];                   // Replay file name (no directory)
+    char phase[8];                   // "tick" (update_game) or "draw" (draw_game into a texture)
+    float p50, p90, p99, max;        // Microseconds
+} t_bench_stats;
+
+static int compare_float(const void *a, const void *b)
+{
+    float x = *(const float *)a, y = *(const float *)b;
+    return (x > y) - (x < y);
+}
+
+static void bench_percentiles(float *us, int n, t_bench_stats *stats)
+{
+    qsort(us, n, sizeof(float), compare_float);
+    stats->p50 = us[(n - 1)/2];
+    stats->p90 = us[(int)(0.90*(n - 1))];
+    stats->p99 = us[(int)(0.99*(n - 1))];
+    stats->max = us[n - 1];
+}
+
+static void print_bench_change(const char *label, double now, double base)
+{
+    // Relative to the baseline; a baseline that timed at 0 (or a damaged file) has no ratio,
+    // so the change is shown in microseconds instead
+    if (base > 0.0) printf("%s %+6.1f%%", label, (now/base - 1.0)*100.0);
+    else printf("%s %+6.2fus", label, now - base);
+}
+
+static bool find_baseline(FILE *baseline, const t_bench_stats *now, t_bench_stats *base)
+{
+    // Baseline file: what --bench-out wrote, "name phase p50 p90 p99 max" per line
+    char line[256];
+    rewind(baseline);
+    while (fgets(line, sizeof(line), baseline) != NULL)
+        if (sscanf(line, "%63s %7s %f %f %f %f", base->name, base->phase, &base->p50, &base->p90, &base->p99, &base->max) == 6 &&
+            strcmp(base->name, now->name) == 0 && strcmp(base->phase, now->phase) == 0) return true;
+    return false;
+}
+
+int bench_replays(const char *listPath, const char *baselinePath, const char *outPath, int runs)
+{
+    int count;
+    char **paths = read_replay_list(listPath, &count);
+    if (paths == NULL)
+    {
+        fprintf(stderr, "bench: can't open %s\n", listPath);
+        return 1;
+    }
+    FILE *baseline = (baselinePath != NULL) ? fopen(baselinePath, "r") : NULL;
+    if (baselinePath != NULL && baseline == NULL) fprintf(stderr, "bench: no baseline at %s, just measuring\n", baselinePath);
+    FILE *out = (outPath != NULL) ? fopen(outPath, "w") : NULL;
+    if (runs < 1) runs = 1;
+    float *tickUs = malloc(REPLAY_MAX_TICKS*sizeof(float));
+    float *drawUs = malloc(REPLAY_MAX_TICKS*sizeof(float));
+    if (tickUs == NULL || drawUs == NULL)
+    {
+        fprintf(stderr, "bench: out of memory for the timings\n");
+        free(tickUs);
+        free(drawUs);
+        if (baseline != NULL) fclose(baseline);
+        if (out != NULL) fclose(out);
+        for (int i = 0; i < count; i++) free(paths[i]);
+        free(paths);
+        return 1;
+    }
+
+    // Drawing needs a GL context: hidden window, frames go into a texture instead of the screen
+    SetConfigFlags(FLAG_WINDOW_HIDDEN);
+    InitWindow(screenWidth, screenHeight, "Arkanoid bench");
+    load_assets();
+    RenderTexture2D target = LoadRenderTexture(screenWidth, screenHeight);
+    t_replay_header header;
+    int regressions = 0;
+
+    for (int r = 0; r < count; r++)
+    {
+        if (!load_replay(paths[r], &header, replayInputs))
+        {
+            fprintf(stderr, "bench: skipping %s (missing, truncated or old version)\n", paths[r]);
+            continue;
+        }
+        const char *name = strrchr(paths[r], '/');
+        name = (name != NULL) ? name + 1 : paths[r];
+        t_bench_stats best[2] = { 0 };
+
+        for (int run = 0; run < runs; run++)
+        {
+            start_replay_game(&header);
+            int n = 0;
+            for (uint32_t t = 0; t < header.ticks && gameState == GAME_PLAYING; t++, n++)
+            {
+                input.down = replayInputs[t] & 0xff;
+                input.pressed = replayInputs[t] >> 8;
+                double t0 = GetTime();
+                update_game();
+                double t1 = GetTime();
+                BeginTextureMode(target);
+                draw_game((Rectangle){ 0, 0, (float)screenWidth, (float)screenHeight });
+                flush_text();
+                EndTextureMode();                            // Flushes the batch, so the draw calls are in...
+                glFinish();                                  // ...and waits for the GPU, so its time counts too
+                tickUs[n] = (float)((t1 - t0)*1e6);
+                drawUs[n] = (float)((GetTime() - t1)*1e6);
+            }
+            if (n == 0) break;
+
+            // Each phase keeps its quietest run; noise only ever adds time
+            t_bench_stats stats[2];
+            bench_percentiles(tickUs, n, &stats[0]);
+            bench_percentiles(drawUs, n, &stats[1]);
+            for (int p = 0; p < 2; p++)
+                if (run == 0 || stats[p].p50 < best[p].p50) best[p] = stats[p];
+        }
+
+        for (int p = 0; p < 2; p++)
+        {
+            t_bench_stats *now = &best[p], base;
+            snprintf(now->name, sizeof(now->name), "%s", name);
+            strcpy(now->phase, (p == 0) ? "tick" : "draw");
+            printf("%-32s %-4s p50 %8.2f p90 %8.2f p99 %8.2f max %9.2f us", now->name, now->phase, now->p50, now->p90, now->p99, now->max);
+            if (baseline != NULL && find_baseline(baseline, now, &base))
+            {
+                bool slower = now->p50 > base.p50*(1.0 + BENCH_TOLERANCE) + BENCH_NOISE_US ||
+                              now->p90 > base.p90*(1.0 + BENCH_TOLERANCE) + BENCH_NOISE_US;
+                print_bench_change("  p50", now->p50, base.p50);
+                print_bench_change(" p90", now->p90, base.p90);
+                printf("%s", slower ? "  REGRESSED" : "");
+                regressions += slower;
+            }
+            printf("\n");
+            if (out != NULL) fprintf(out, "%s %s %.3f %.3f %.3f %.3f\n", now->name, now->phase, now->p50, now->p90, now->p99, now->max);
+        }
+    }
+    if (baseline != NULL) printf("bench: %d regressed phase%s (over %.0f%% and %.1f us slower than baseline)\n",
+                                 regressions, (regressions == 1) ? "" : "s", BENCH_TOLERANCE*100.0, BENCH_NOISE_US);
+
+    free(tickUs);
+    free(drawUs);
+    UnloadRenderTexture(target);
+    unload_assets();
+    CloseWindow();
+    if (baseline != NULL) fclose(baseline);
+    if (out != NULL) fclose(out);
+    for (int i = 0; i < count; i++) free(paths[i]);
+    free(paths);
+    return regressions > 0;
+}
+
+//------------------------------------------------------------------------------------
+// Attract mode - recorded games on an idle title screen, streamed from mapped files
+//------------------------------------------------------------------------------------
+bool open_replay_stream(t_replay_stream *stream, const char *path)
+{
+    // Only the header is read now; input pages come in as playback reaches them
+    memset(stream, 0, sizeof(*stream));
+#ifndef _WIN32
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    void *map = (fstat(fd, &info) == 0 && (size_t)info.st_size >= sizeof(t_replay_header)) ?
+                mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    close(fd);                                               // The mapping keeps the file
+    if (map == MAP_FAILED) return false;
+    madvise(map, info.st_size, MADV_SEQUENTIAL);
+    stream->map = map;
+    stream->mapSize = info.st_size;
+#else
+    FILE *file = fopen(path, "rb");                          // No mmap here: read the file whole
+    if (file == NULL) return false;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    stream->map = (size >= (long)sizeof(t_replay_header)) ? malloc(size) : NULL;
+    stream->mapSize = (size_t)size;
+    bool read = stream->map != NULL && fread(stream->map, 1, size, file) == (size_t)size;
+    fclose(file);
+    if (!read) { free(stream->map); stream->map = NULL; return false; }
+#endif
+    memcpy(&stream->header, stream->map, sizeof(t_replay_header));
+    stream->header.level[REPLAY_LEVEL_CHARS - 1] = '\0';
+    stream->inputs = (const uint16_t *)((const char *)stream->map + sizeof(t_replay_header));
+    if (memcmp(stream->header.magic, "ARKR", 4) != 0 || stream->header.version != REPLAY_VERSION ||
+        stream->header.ticks > (stream->mapSize - sizeof(t_replay_header))/sizeof(uint16_t))
+    {
+        close_replay_stream(stream);
+        return false;
+    }
+    return true;
+}
+
+void close_replay_stream(t_replay_stream *stream)
+{
+    if (stream->map == NULL) return;
+#ifndef _WIN32
+    munmap(stream->map, stream->mapSize);
+#else
+    free(stream->map);
+#endif
+    stream->map = NULL;
+}
+
+static uint16_t replay_stream_input(t_replay_stream *stream)
+{
+    // Every ATTRACT_READAHEAD ticks, ask for the next stretch so playback never waits on a page fault
+    uint32_t tick = stream->next++;
+#ifndef _WIN32
+    if (tick % ATTRACT_READAHEAD == 0)
+    {
+        uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+        uintptr_t from = ((uintptr_t)&stream->inputs[tick]) & ~(page - 1);
+        uintptr_t end = (uintptr_t)stream->map + stream->mapSize;
+        uintptr_t to = (uintptr_t)&stream->inputs[tick] + 2*ATTRACT_READAHEAD*sizeof(uint16_t);
+        madvise((void *)from, ((to < end) ? to : end) - from, MADV_WILLNEED);
+    }
+#endif
+    return stream->inputs[tick];
+}
+
+static void *attract_prefetch(void *arg)
+{
+    // Opens the next replay in the list that works and touches its first inputs
+    (void)arg;
+    t_replay_stream *stream = &attractStreams[1 - attractPlaying];
+    for (int tried = 0; tried < attractCount; tried++)
+    {
+        const char *path = attractPaths[attractNext];
+        attractNext = (attractNext + 1) % attractCount;
+        if (!open_replay_stream(stream, path)) continue;
+        volatile uint16_t first = (stream->header.ticks > 0) ? stream->inputs[0] : 0;
+        (void)first;
+        ATOMIC_STORE(&attractReady, 1);
+        return NULL;
+    }
+    ATOMIC_STORE(&attractReady, 2);
+    return NULL;
+}
+
+static void prefetch_attract(void)
+{
+    ATOMIC_STORE(&attractReady, 0);
+#ifndef _WIN32
+    attractThreadBusy = pthread_create(&attractThread, NULL, attract_prefetch, NULL) == 0;
+    if (!attractThreadBusy) attract_prefetch(NULL);          // No thread: open it here
+#else
+    attract_prefetch(NULL);
+#endif
+}
+
+static bool next_attract_game(void)
+{
+    // Swaps in the prefetched replay and starts fetching the one after; false while it isn't ready
+    unsigned int ready = ATOMIC_LOAD(&attractReady);
+    if (ready == 0) return false;
+#ifndef _WIN32
+    if (attractThreadBusy) pthread_join(attractThread, NULL);
+    attractThreadBusy = false;
+#endif
+    if (ready == 2)
+    {
+        fprintf(stderr, "attract: none of the listed replays can be played\n");
+        stop_attract();                                      // Turns attract mode off
+        return false;
+    }
+    close_replay_stream(&attractStreams[attractPlaying]);
+    attractPlaying = 1 - attractPlaying;
+    prefetch_attract();
+    start_replay_game(&attractStreams[attractPlaying].header);
+    return true;
+}
+
+void start_attract(const char *listPath)
+{
+    attractPaths = read_replay_list(listPath, &attractCount);
+    if (attractPaths == NULL) { fprintf(stderr, "attract: can't open %s\n", listPath); attractCount = 0; return; }
+    if (attractCount > 0) prefetch_attract();
+}
+
+void update_attract(void)
+{
+    if (attractCount == 0) return;
+    bool touched = inputSampled != 0 || input.pressed != 0;  // Real keys only: input.down still holds the replay's
+    if (!attractOn)
+    {
+        attractIdle = (gameState == GAME_TITLE && !touched) ? attractIdle + 1 : 0;
+        if (attractIdle < ATTRACT_IDLE_TICKS) return;
+        attractLevel = levelPath;
+        if (!next_attract_game()) return;                    // Not prefetched yet, try next tick
+        attractOn = true;
+    }
+    else if (touched)
+    {
+        // Player is back: title screen, their level, and this key doesn't also start a game
+        attractOn = false;
+        attractIdle = 0;
+        gameState = GAME_TITLE;
+        paused = false;
+        wait_level();
+        if (levelPath != attractLevel) { levelPath = attractLevel; levelReady = false; } // Rebuilt by the next title tick
+        input = (t_input){ 0 };
+        return;
+    }
+    else
+    {
+        t_replay_stream *playing = &attractStreams[attractPlaying];
+        if ((gameState != GAME_PLAYING || playing->next >= playing->header.ticks) && !next_attract_game()) return;
+    }
+
+    uint16_t bits = replay_stream_input(&attractStreams[attractPlaying]);
+    input.down = bits & 0xff;
+    input.pressed = bits >> 8;
+}
+
+void stop_attract(void)
+{
+#ifndef _WIN32
+    if (attractThreadBusy) pthread_join(attractThread, NULL);
+    attractThreadBusy = false;
+#endif
+    close_replay_stream(&attractStreams[0]);
+    close_replay_stream(&attractStreams[1]);
+    for (int i = 0; i < attractCount; i++) free(attractPaths[i]);
+    free(attractPaths);
+    attractPaths = NULL;
+    attractCount = 0;
+}
+
+//------------------------------------------------------------------------------------
+// Wall - many games in one window, each swapped into the globals to update and draw
+//------------------------------------------------------------------------------------
+static void load_instance(const t_game_instance *game, bool withBvh)
+{
+    player = game->player;
+    memcpy(balls, game->balls, sizeof(balls));
+    ballsCount = game->ballsCount;
+    memcpy(powerups, game->powerups, sizeof(powerups));
+    bricksLeft = game->bricksLeft;
+    score = game->score;
+    gameState = game->gameState;
+    paused = game->paused;
+    waiting_for_launch = game->waitingForLaunch;
+    gameSeed = game->gameSeed;
+    rngState = game->rngState;
+    memcpy(bricksAlive, game->bricksAlive, (bricksCount + 63)/64*sizeof(uint64_t));
+    memcpy(script.regs + SCRIPT_VAR_BASE, game->scriptVars, sizeof(game->scriptVars));
+    if (withBvh) memcpy(bvh, game->bvh, bvhCount*sizeof(t_bvh_node));   // Drawing doesn't need it
+}
+
+static void save_instance(t_game_instance *game)
+{
+    game->player = player;
+    memcpy(game->balls, balls, sizeof(balls));
+    game->ballsCount = ballsCount;
+    memcpy(game->powerups, powerups, sizeof(powerups));
+    game->bricksLeft = bricksLeft;
+    game->score = score;
+    game->gameState = gameState;
+    game->paused = paused;
+    game->waitingForLaunch = waiting_for_launch;
+    game->gameSeed = gameSeed;
+    game->rngState = rngState;
+    memcpy(game->bricksAlive, bricksAlive, (bricksCount + 63)/64*sizeof(uint64_t));
+    memcpy(game->scriptVars, script.regs + SCRIPT_VAR_BASE, sizeof(game->scriptVars));
+    memcpy(game->bvh, bvh, bvhCount*sizeof(t_bvh_node));
+}
+
+static void start_wall_game(t_game_instance *game)
+{
+    gameSeed = (uint32_t)rand();
+    init_game();
+    gameState = GAME_PLAYING;
+    save_instance(game);
+    game->endTicks = 0;
+}
+
+void start_wall(int count)
+{
+    // Swapping only copies what a game changes: the mask words and BVH nodes this level uses
+    wallCount = (count < WALL_MAX) ? count : WALL_MAX;
+    wall = calloc(wallCount, sizeof(t_game_instance));
+    if (wall == NULL) wallCount = 0;
+    prepare_level();
+    bool allocated = (wall != NULL);
+    for (int i = 0; i < wallCount; i++)                      // Everything first, so a failure leaves no game started
+    {
+        allocated &= (wall[i].bricksAlive = malloc((bricksCount + 63)/64*sizeof(uint64_t))) != NULL;
+        allocated &= (wall[i].bvh = malloc((bvhCount > 0 ? bvhCount : 1)*sizeof(t_bvh_node))) != NULL;
+    }
+    if (!allocated)
+    {
+        fprintf(stderr, "wall: out of memory for %d games, playing just one\n", count);
+        stop_wall();                                         // Frees what was allocated; wallCount 0 = no wall
+        return;
+    }
+    for (int i = 0; i < wallCount; i++)
+    {
+        start_wall_game(&wall[i]);
+        extract_features(wallFeatures[i]);
+    }
+}
+
+void stop_wall(void)
+{
+    for (int i = 0; i < wallCount; i++) { free(wall[i].bricksAlive); free(wall[i].bvh); }
+    free(wall);
+    wall = NULL;
+    wallCount = 0;
+}
+
+void update_draw_wall(void)
+{
+    // Every tile gets the same keys (or the autopilot); finished games start over on their own
+    double now = GetTime();
+    int ticks = 0;
+    while (simTime + TICK_DT <= now && ticks < MAX_TICKS_PER_FRAME)
+    {
+        simTime += TICK_DT;
+        consume_input(simTime);
+        toggle_autopilot();                                  // For the whole wall, before any tile runs
+        t_input keys = input;
+        double tickStart = GetTime();
+
+        // A network plays every tile in one mlp_forward() call, on the features each game was left
+        // with last tick; scripts keep variables per game, so they still run as each tile is loaded
+        static float actions[WALL_MAX][3];
+        bool batched = autopilotOn && !attractOn && script.length == 0;
+        if (batched) mlp_forward(&autopilot, wallFeatures[0], actions[0], wallCount);
+        for (int i = 0; i < wallCount; i++)
+        {
+            load_instance(&wall[i], true);
+            soundMuted = (i > 0);
+            input = keys;
+            if (!batched) apply_autopilot();
+            else if (gameState == GAME_PLAYING && !paused) press_policy_keys(actions[i]);
+            update_game();
+            save_instance(&wall[i]);
+            if (gameState != GAME_PLAYING && (++wall[i].endTicks >= WALL_RESTART_TICKS || gameState == GAME_TITLE))
+                start_wall_game(&wall[i]);
+            extract_features(wallFeatures[i]);
+        }
+        publish_tick(GetTime() - tickStart);                 // One tick of the wall, all tiles
+        soundMuted = false;
+        ticks++;
+    }
+    if (ticks == MAX_TICKS_PER_FRAME) simTime = now;
+    publish_metrics(now - lastFrameTime);
+    lastFrameTime = now;
+    double updated = GetTime();
+
+    // draw_game() scales with the matrix stack, which transforms vertices as they're batched,
+    // so all tiles share one batch (and the one baked background texture); same-size tiles
+    // share one cached layout
+    int cols = 1;
+    while (cols*cols < wallCount) cols++;
+    int rows = (wallCount + cols - 1)/cols;
+    float tileW = (float)GetScreenWidth()/cols, tileH = (float)GetScreenHeight()/rows;
+    BeginDrawing();
+    ClearBackground(BLACK);
+    for (int i = 0; i < wallCount; i++)
+    {
+        load_instance(&wall[i], false);
+        draw_game((Rectangle){ (i % cols)*tileW, (i/cols)*tileH, tileW, tileH });
+    }
+    flush_text();                                            // Every tile's text in one go
+    if (ttyPath != NULL)
+    {
+        load_instance(&wall[0], false);                      // The terminal mirrors the tile with sound
+        update_tty(now);
+    }
+    double drawn = GetTime();
+    EndDrawing();
+    if (startupTime[STARTUP_FIRST_FRAME] == 0.0) startup_mark(STARTUP_FIRST_FRAME);
+    double presented = GetTime();
+    wait_for_next_frame();
+
+    if (flightDir != NULL)
+    {
+        float ms[4] = { (float)((updated - now)*1e3), (float)((drawn - updated)*1e3),
+                        (float)((presented - drawn)*1e3), (float)((GetTime() - presented)*1e3) };
+        flight_frame(now, ms);
+    }
+    flush_log();
+}
+
+//------------------------------------------------------------------------------------
+// Terminal view - the playfield in half-block characters, only changed cells sent
+//------------------------------------------------------------------------------------
+static uint8_t tty_color(Color c)
+{
+    return (uint8_t)(16 + 36*((c.r*5 + 127)/255) + 6*((c.g*5 + 127)/255) + (c.b*5 + 127)/255);   // xterm 6x6x6 cube
+}
+
+static void tty_fill(uint8_t px[TTY_ROWS*2][TTY_COLS], Rectangle r, uint8_t color)
+{
+    // Pixels whose centres are inside r; anything thinner than a pixel still gets one
+    int x0 = (int)(r.x/10.0f), x1 = (int)((r.x + r.width)/10.0f - 0.5f);
+    int y0 = (int)(r.y/10.0f), y1 = (int)((r.y + r.height)/10.0f - 0.5f);
+    if (x1 < x0) x1 = x0;
+    if (y1 < y0) y1 = y0;
+    for (int y = (y0 > 0 ? y0 : 0); y <= y1 && y < TTY_ROWS*2; y++)
+        for (int x = (x0 > 0 ? x0 : 0); x <= x1 && x < TTY_COLS; x++) px[y][x] = color;
+}
+
+static void tty_emit(const char *format, ...)
+{
+    va_list ap;
+    va_start(ap, format);
+    int n = vsnprintf(ttyOut + ttyOutLength, TTY_OUT_MAX - ttyOutLength, format, ap);
+    va_end(ap);
+    if (n > 0) ttyOutLength += (ttyOutLength + n < TTY_OUT_MAX) ? n : 0;
+}
+
+static void render_tty(void)
+{
+    // Draw the playfield into 10x10-unit pixels, then turn changed cells into escape sequences
+    static uint8_t px[TTY_ROWS*2][TTY_COLS];
+    for (int y = 0; y < TTY_ROWS*2; y++)                     // Same gradient as the baked background
+    {
+        float t = (y*10.0f)/screenHeight;
+        uint8_t row = tty_color((Color){ (unsigned char)(40*(1 - t) + 130*t), (unsigned char)(40*(1 - t) + 130*t), (unsigned char)(90*(1 - t) + 220*t), 255 });
+        memset(px[y], row, TTY_COLS);
+    }
+    if (gameState == GAME_PLAYING)
+    {
+        for (int w = 0; w*64 < bricksCount; w++)
+            for (uint64_t alive = bricksAlive[w]; alive != 0; alive &= alive - 1)
+            {
+                const t_brick *brick = &bricks[w*64 + __builtin_ctzll(alive)];
+                if (brick->poly < 0) { tty_fill(px, brick->rect, tty_color(brick->color)); continue; }
+                const t_brick_poly *poly = &brickPolys[brick->poly];
+                uint8_t color = tty_color(brick->color);
+                for (int y = (int)(brick->rect.y/10.0f); y*10.0f < brick->rect.y + brick->rect.height && y < TTY_ROWS*2; y++)
+                    for (int x = (int)(brick->rect.x/10.0f); x*10.0f < brick->rect.x + brick->rect.width && x < TTY_COLS; x++)
+                    {
+                        float cx = x*10.0f + 5.0f, cy = y*10.0f + 5.0f;
+                        bool inside = (y >= 0 && x >= 0);
+                        for (int k = 0; k < BRICK_POLY_VERTS && inside; k++) inside = poly->nx[k]*cx + poly->ny[k]*cy - poly->d[k] <= 0.0f;
+                        if (inside) px[y][x] = color;
+                    }
+            }
+        tty_fill(px, (Rectangle){ player.pos.x, player.pos.y, player.size.x, player.size.y },
+                 tty_color(player.expanded ? YELLOW : DARKBLUE));
+        for (int i = 0; i < POWERUPS_MAX; i++)
+            if (powerups[i].active)
+                tty_fill(px, (Rectangle){ powerups[i].pos.x - 10, powerups[i].pos.y - 10, 20, 20 },
+                         tty_color((powerups[i].type == POWERUP_EXPAND) ? YELLOW : (powerups[i].type == POWERUP_EXTRA_LIFE) ? RED : MAROON));
+        for (int b = 0; b < BALLS_MAX; b++)
+            if (balls[b].active)
+                tty_fill(px, (Rectangle){ balls[b].pos.x - balls[b].radius, balls[b].pos.y - balls[b].radius,
+                                          2*balls[b].radius, 2*balls[b].radius }, tty_color(RED));
+    }
+
+    t_tty_cell next[TTY_ROWS + 1][TTY_COLS];
+    for (int r = 0; r < TTY_ROWS; r++)
+        for (int c = 0; c < TTY_COLS; c++) next[r][c] = (t_tty_cell){ 0, px[2*r][c], px[2*r + 1][c] };
+    static const char *stateNames[] = { "TITLE", "PLAYING", "GAME OVER", "VICTORY" };
+    char status[TTY_COLS + 1];
+    snprintf(status, sizeof(status), " SCORE %04d  LIVES %d  BRICKS %d  %s%s", score, player.life, bricksLeft,
+             stateNames[gameState], paused ? " (PAUSED)" : "");
+    for (int c = 0, end = 0; c < TTY_COLS; c++)
+    {
+        end |= (status[c] == '\0');
+        next[TTY_ROWS][c] = (t_tty_cell){ end ? ' ' : status[c], 231, 16 };
+    }
+
+    // Only cells that changed; cursor moves and colour changes only when needed
+    int cursorR = -1, cursorC = -1, fg = -1, bg = -1;
+    for (int r = 0; r <= TTY_ROWS; r++)
+        for (int c = 0; c < TTY_COLS; c++)
+        {
+            t_tty_cell cell = next[r][c];
+            if (memcmp(&cell, &ttyCells[r][c], sizeof(cell)) == 0) continue;
+            if (r != cursorR || c != cursorC) tty_emit("\x1b[%d;%dH", r + 1, c + 1);
+            if (cell.fg != fg || cell.bg != bg) tty_emit("\x1b[38;5;%d;48;5;%dm", cell.fg, cell.bg);
+            if (cell.ch == 0) tty_emit("\xe2\x96\x80");               // U+2580 upper half block
+            else tty_emit("%c", cell.ch);
+            ttyCells[r][c] = cell;
+            cursorR = r; cursorC = c + 1; fg = cell.fg; bg = cell.bg;
+        }
+}
+
+void start_tty(void)
+{
+#ifndef _WIN32
+    if (ttyPath == NULL) return;
+    ttyFd = (strcmp(ttyPath, "-") == 0) ? STDOUT_FILENO : open(ttyPath, O_WRONLY | O_NOCTTY | O_CREAT | O_TRUNC, 0644);
+    if (ttyFd < 0) { fprintf(stderr, "tty: can't open %s\n", ttyPath); ttyPath = NULL; return; }
+    ttyFlags = fcntl(ttyFd, F_GETFL);
+    fcntl(ttyFd, F_SETFL, ttyFlags | O_NONBLOCK);           // A slow link must never stall a frame
+    memset(ttyCells, 0xff, sizeof(ttyCells));                // Nothing matches: first update draws everything
+    tty_emit("\x1b[?25l\x1b[2J");                             // Hide cursor, clear
+#else
+    if (ttyPath != NULL) fprintf(stderr, "tty: not supported on this platform\n");
+    ttyPath = NULL;
+#endif
+}
+
+void update_tty(double now)
+{
+#ifndef _WIN32
+    if (ttyPath == NULL) return;
+    // Finish sending the last update before making a new one, so no escape sequence is cut in half
+    if (ttyOutSent == ttyOutLength)
+    {
+        if (now - ttyLastTime < 1.0/TTY_HZ) return;
+        ttyLastTime = now;
+        ttyOutLength = ttyOutSent = 0;
+        render_tty();
+    }
+    ssize_t n = write(ttyFd, ttyOut + ttyOutSent, ttyOutLength - ttyOutSent);
+    if (n > 0) ttyOutSent += (int)n;                         // EAGAIN: link is busy, the rest goes next frame
+#else
+    (void)now;
+#endif
+}
+
+void stop_tty(void)
+{
+#ifndef _WIN32
+    if (ttyPath == NULL) return;
+    fcntl(ttyFd, F_SETFL, ttyFlags);                         // Blocking again, so the reset gets through
+    if (ttyOutSent < ttyOutLength && write(ttyFd, ttyOut + ttyOutSent, ttyOutLength - ttyOutSent) < 0) { }
+    static const char reset[] = "\x1b[0m\x1b[?25h\n";
+    if (write(ttyFd, reset, sizeof(reset) - 1) < 0) { }
+    if (ttyFd != STDOUT_FILENO) close(ttyFd);
+    ttyPath = NULL;
+#endif
+}
+
+#ifndef _WIN32
+static volatile sig_atomic_t headlessStop = 0;
+static void stop_headless(int sig) { (void)sig; headlessStop = 1; }
+#endif
+
+int run_headless(void)
+{
+    // The fixed-tick loop of update_draw_frame() without raylib: no window means no keyboard and
+    // no GetTime(), so the autopilot or script plays game after game and the terminal is the view
+#ifndef _WIN32
+    if (ttyPath == NULL || (autopilot.layers == 0 && script.length == 0))
+    {
+        fprintf(stderr, "headless: needs --tty and --autopilot <weights> or --script <file>\n");
+        return 1;
+    }
+    start_tty();
+    if (ttyPath == NULL) return 1;                           // start_tty() said why
+    struct sigaction action = { 0 };
+    action.sa_handler = stop_headless;                       // Ctrl-C still gets the terminal reset
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    srand((unsigned int)time(0));
+    int endTicks = WALL_RESTART_TICKS;                       // Starts a game on the first tick
+    simTime = startup_clock();
+    while (!headlessStop)
+    {
+        double now = startup_clock();
+        int ticks = 0;
+        while (simTime + TICK_DT <= now && ticks < MAX_TICKS_PER_FRAME)
+        {
+            simTime += TICK_DT;
+            if (gameState != GAME_PLAYING && (++endTicks >= WALL_RESTART_TICKS || gameState == GAME_TITLE))
+            {
+                gameSeed = (uint32_t)rand();                 // Finished games start over, as on a --wall
+                init_game();
+                gameState = GAME_PLAYING;
+                endTicks = 0;
+            }
+            input = (t_input){ 0 };
+            apply_autopilot();
+            step_game();
+            ticks++;
+        }
+        if (ticks == MAX_TICKS_PER_FRAME) simTime = now;      // Too far behind: drop the backlog
+        update_tty(now);
+
+        double wait = simTime + TICK_DT - startup_clock();   // Sleep until the next tick is due
+        if (wait > 0.0) nanosleep(&(struct timespec){ 0, (long)(wait*1e9) }, NULL);
+    }
+    stop_tty();
+    return 0;
+#else
+    fprintf(stderr, "headless: not supported on this platform\n");
+    return 1;
+#endif
+}
+
+//------------------------------------------------------------------------------------
+// Rewind debugger - snapshots plus per-tick input, any tick rebuilt by resimulating
+//------------------------------------------------------------------------------------
+void start_rewind(void)
+{
+    if (!rewindEnabled) return;
+    rewindSnaps = calloc(REWIND_SNAPSHOTS, sizeof(t_game_instance));
+    if (rewindSnaps == NULL) rewindEnabled = false;
+}
+
+void stop_rewind(void)
+{
+    free(rewindSnaps);
+    free(rewindMemory);
+    rewindSnaps = NULL;
+    rewindMemory = NULL;
+    rewindMemorySize = 0;
+}
+
+static void rewind_begin(void)
+{
+    // A game just started: its first tick is the oldest history there will be. Snapshot buffers
+    // are sized for this level and only reallocated when a bigger one comes along
+    size_t words = (bricksCount + 63)/64, nodes = (bvhCount > 0) ? bvhCount : 1;
+    size_t each = words*sizeof(uint64_t) + nodes*sizeof(t_bvh_node);
+    size_t count = (size_t)REWIND_BUDGET_MB*1024*1024/each;
+    if (count > REWIND_SNAPSHOTS) count = REWIND_SNAPSHOTS;
+    if (count < 2) count = 2;
+    if (count*each > rewindMemorySize)
+    {
+        free(rewindMemory);
+        rewindMemory = malloc(count*each);
+        rewindMemorySize = (rewindMemory != NULL) ? count*each : 0;
+    }
+    rewindLive = (rewindMemory != NULL);
+    if (!rewindLive) return;
+    for (size_t i = 0; i < count; i++)
+    {
+        rewindSnaps[i].bricksAlive = (uint64_t *)(rewindMemory + i*each);
+        rewindSnaps[i].bvh = (t_bvh_node *)(rewindMemory + i*each + words*sizeof(uint64_t));
+    }
+    rewindSnapCount = (int)count;
+    rewindFirst = rewindTick = rewindLatest = 0;
+    save_instance(&rewindSnaps[0]);
+}
+
+void rewind_record(t_gamestate before)
+{
+    // After every live tick: its input, and a snapshot every REWIND_SNAPSHOT_TICKS
+    if (rewindSnaps == NULL || attractOn) return;
+    if (before == GAME_TITLE)
+    {
+        if (gameState == GAME_PLAYING) rewind_begin();
+        return;
+    }
+    if (!rewindLive) return;
+    rewindInputs[rewindLatest % REWIND_TICKS] = (uint16_t)(input.down | (input.pressed << 8));
+    rewindTick = ++rewindLatest;
+    if (rewindLatest % REWIND_SNAPSHOT_TICKS == 0)
+    {
+        int snap = rewindLatest/REWIND_SNAPSHOT_TICKS;
+        save_instance(&rewindSnaps[snap % rewindSnapCount]);
+        if (snap >= rewindSnapCount) rewindFirst = (snap - rewindSnapCount + 1)*REWIND_SNAPSHOT_TICKS;
+    }
+    if (gameState == GAME_TITLE) rewindLive = false;        // Title ticks use rand(), they can't be replayed
+}
+
+static void rewind_tick(uint16_t keys)
+{
+    // One tick of history again; the overlay shows what this tick did
+    input.down = keys & 0xff;
+    input.pressed = keys >> 8;
+    update_game();
+}
+
+static void rewind_seek(int tick)
+{
+    // Nearest snapshot at or before tick, then forward with the recorded input (at most
+    // REWIND_SNAPSHOT_TICKS ticks, well under a millisecond). Starting one snapshot early when
+    // tick is a snapshot tick means the overlay always has a tick to show
+    if (tick < rewindFirst) tick = rewindFirst;
+    if (tick > rewindLatest) tick = rewindLatest;
+    if (tick == rewindTick) return;
+    soundMuted = rewindReplaying = true;
+    if (tick == rewindTick + 1) rewind_tick(rewindInputs[rewindTick % REWIND_TICKS]);
+    else
+    {
+        int snap = ((tick > rewindFirst) ? tick - 1 : tick)/REWIND_SNAPSHOT_TICKS;
+        load_instance(&rewindSnaps[snap % rewindSnapCount], true);
+        for (int t = snap*REWIND_SNAPSHOT_TICKS; t < tick; t++) rewind_tick(rewindInputs[t % REWIND_TICKS]);
+    }
+    soundMuted = rewindReplaying = false;
+    rewindTick = tick;
+}
+
+static void rewind_resume(void)
+{
+    // Play on from the tick on screen: later history is dropped, and so is input typed while frozen
+    if (rewindTick < rewindLatest)
+    {
+        rewindLatest = rewindTick;
+        if (recording) replayHeader.ticks = (uint32_t)rewindTick;   // Replay ticks are counted the same way
+    }
+    rewindFrozen = false;
+    inputTail = inputHead;
+    inputTapped = 0;
+    input.down = inputSampled;
+    input.pressed = 0;
+}
+
+void update_rewind(void)
+{
+    // Debugger keys, once per frame. Frozen, the game only moves when stepped
+    unsigned int keys = rewindKeys;
+    rewindKeys = 0;
+    if (rewindSnaps == NULL || keys == 0) return;
+    if (keys & (1u << REWIND_KEY_FREEZE))
+    {
+        if (rewindFrozen) rewind_resume();
+        else rewindFrozen = rewindLive;                     // Only while the state is the latest tick
+    }
+    if (!rewindFrozen) return;
+
+    int target = rewindTick;
+    if (keys & (1u << REWIND_KEY_BACK)) target -= 1;
+    if (keys & (1u << REWIND_KEY_BACK_SECOND)) target -= TICK_RATE;
+    if (keys & (1u << REWIND_KEY_FORWARD)) target += 1;
+    if (keys & (1u << REWIND_KEY_FORWARD_SECOND)) target += TICK_RATE;
+    if (target > rewindLatest && rewindTick == rewindLatest && rewindLive)
+    {
+        // Past the end of history: a new tick with the game keys held right now (logged, unlike seeks)
+        input.down = inputSampled;
+        input.pressed = 0;
+        soundMuted = true;
+        step_game();
+        soundMuted = false;
+        return;
+    }
+    rewind_seek(target);
+}
+
+static void draw_rewind_overlay(void)
+{
+    // Where each ball came from this tick, where it is heading, and what it touched
+    for (int b = 0; b < BALLS_MAX; b++)
+    {
+        if (!balls[b].active) continue;
+        Vector2 pos = balls[b].pos, spd = balls[b].spd;
+        DrawCircleLines((int)(pos.x - spd.x), (int)(pos.y - spd.y), balls[b].radius, GRAY);
+        DrawCircleLines((int)pos.x, (int)pos.y, balls[b].radius, WHITE);
+        DrawLineEx(pos, (Vector2){ pos.x + spd.x*REWIND_VELOCITY_SCALE, pos.y + spd.y*REWIND_VELOCITY_SCALE }, 2.0f, GREEN);
+        for (int c = 0; c < rewindView.contactsCount[b]; c++)
+        {
+            const t_contact *contact = &rewindView.contacts[b][c];
+            DrawRectangleLinesEx(bricks[contact->brick].rect, 3.0f, MAGENTA);
+            Vector2 at = { pos.x - contact->normal.x*balls[b].radius, pos.y - contact->normal.y*balls[b].radius };
+            DrawLineEx(at, (Vector2){ at.x + contact->normal.x*30, at.y + contact->normal.y*30 }, 2.0f, ORANGE);
+            DrawCircleV(at, 4.0f, ORANGE);
+        }
+    }
+    if (rewindView.paddleHits != 0)
+        DrawRectangleLinesEx((Rectangle){ player.pos.x, player.pos.y, player.size.x, player.size.y }, 3.0f, GREEN);
+}
+
+//------------------------------------------------------------------------------------
+// Autopilot - small fully-connected network (ReLU hidden layers) that plays from the features
+//------------------------------------------------------------------------------------
+bool load_mlp(t_mlp *net, const char *path)
+{
+    // File: "ARKM", uint32 layers, uint32 width[layers + 1], then per layer float
+    // weights[out][in] followed by float bias[out]. width[0] must be FEATURE_COUNT and the last
+    // width 3 (left, right, launch; a key is pressed when its output is > 0)
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) return false;
+
+    char magic[4];
+    uint32_t layers, width[MLP_MAX_LAYERS + 1];
+    bool ok = fread(magic, 4, 1, file) == 1 && memcmp(magic, "ARKM", 4) == 0 &&
+              fread(&layers, 4, 1, file) == 1 && layers >= 1 && layers <= MLP_MAX_LAYERS &&
+              fread(width, 4, layers + 1, file) == layers + 1 &&
+              width[0] == FEATURE_COUNT && width[layers] == 3;
+    for (uint32_t l = 0; ok && l <= layers; l++) ok = width[l] >= 1 && width[l] <= MLP_MAX_WIDTH;
+
+    memset(net, 0, sizeof(*net));                           // Padding lanes stay zero
+    for (uint32_t l = 0; ok && l < layers; l++)
+    {
+        int in = (int)width[l], out = (int)width[l + 1];
+        int outPadded = (out + MLP_LANES - 1)/MLP_LANES*MLP_LANES;
+        for (int j = 0; ok && j < out; j++)
+            for (int i = 0; ok && i < in; i++)
+                ok = fread(&net->weights[l][i*outPadded + j], 4, 1, file) == 1;
+        ok = ok && fread(net->bias[l], 4, out, file) == (size_t)out;
+    }
+    fclose(file);
+    if (!ok) { memset(net, 0, sizeof(*net)); return false; }
+
+    net->layers = (int)layers;
+    for (uint32_t l = 0; l <= layers; l++)
+    {
+        net->width[l] = (int)width[l];
+        net->padded[l] = ((int)width[l] + MLP_LANES - 1)/MLP_LANES*MLP_LANES;
+    }
+    return true;
+}
+
+static void mlp_layer(const float *restrict in, int nIn, const float *restrict w, const float *restrict bias,
+                      float *restrict out, int nOut, int rows, bool relu)
+{
+    // out = bias + in * W^T for `rows` rows MLP_MAX_WIDTH floats apart. For each MLP_LANES-wide
+    // column of outputs, MLP_ROWS rows at a time are accumulated in registers: a slice of weight
+    // row i is loaded once and multiply-added into all of them. The column's
+    // weights (nIn*MLP_LANES floats, a few KB) stay in L1 while the whole batch goes over them.
+    // Every output sums in the same order on both paths, so a row's result doesn't depend on the batch
+    for (int j = 0; j < nOut; j += MLP_LANES)
+    {
+        for (int r = 0; r + MLP_ROWS <= rows; r += MLP_ROWS)
+        {
+            const float *restrict x = in + r*MLP_MAX_WIDTH;
+            float a0[MLP_LANES], a1[MLP_LANES], a2[MLP_LANES], a3[MLP_LANES];   // MLP_ROWS rows
+            for (int k = 0; k < MLP_LANES; k++) a0[k] = a1[k] = a2[k] = a3[k] = bias[j + k];
+            for (int i = 0; i < nIn; i++)
+            {
+                const float *restrict wv = w + i*nOut + j;
+                float x0 = x[i], x1 = x[MLP_MAX_WIDTH + i], x2 = x[2*MLP_MAX_WIDTH + i], x3 = x[3*MLP_MAX_WIDTH + i];
+                for (int k = 0; k < MLP_LANES; k++)
+                {
+                    a0[k] += x0*wv[k];
+                    a1[k] += x1*wv[k];
+                    a2[k] += x2*wv[k];
+                    a3[k] += x3*wv[k];
+                }
+            }
+            float *restrict o = out + r*MLP_MAX_WIDTH + j;
+            for (int k = 0; k < MLP_LANES; k++)
+            {
+                o[k] = (relu && a0[k] < 0.0f) ? 0.0f : a0[k];
+                o[MLP_MAX_WIDTH + k] = (relu && a1[k] < 0.0f) ? 0.0f : a1[k];
+                o[2*MLP_MAX_WIDTH + k] = (relu && a2[k] < 0.0f) ? 0.0f : a2[k];
+                o[3*MLP_MAX_WIDTH + k] = (relu && a3[k] < 0.0f) ? 0.0f : a3[k];
+            }
+        }
+    }
+    for (int r = rows/MLP_ROWS*MLP_ROWS; r < rows; r++)     // The last few rows, or a batch of one
+    {
+        const float *restrict x = in + r*MLP_MAX_WIDTH;
+        float *restrict o = out + r*MLP_MAX_WIDTH;
+        for (int j = 0; j < nOut; j += MLP_LANES)
+            for (int k = 0; k < MLP_LANES; k++) o[j + k] = bias[j + k];
+        for (int i = 0; i < nIn; i++)                       // axpy over the whole of weight row i
+        {
+            const float *restrict wv = w + i*nOut;
+            for (int j = 0; j < nOut; j += MLP_LANES)
+                for (int k = 0; k < MLP_LANES; k++) o[j + k] += x[i]*wv[j + k];
+        }
+        if (relu)
+            for (int j = 0; j < nOut; j += MLP_LANES)
+                for (int k = 0; k < MLP_LANES; k++) o[j + k] = (o[j + k] > 0.0f) ? o[j + k] : 0.0f;
+    }
+}
+
+#ifdef MLP_AVX2
+__attribute__((target("avx2,fma")))
+static void mlp_layer_avx2(const float *restrict in, int nIn, const float *restrict w, const float *restrict bias,
+                           float *restrict out, int nOut, int rows, bool relu)
+{
+    // mlp_layer() with one AVX register per MLP_LANES-wide slice and fused multiply-adds. Only
+    // this function is built for AVX2/FMA, so the game's own float math rounds as on any other
+    // build; the policy's outputs may differ from the scalar kernel's in the last bit
+    const __m256 zero = _mm256_setzero_ps();
+    for (int j = 0; j < nOut; j += MLP_LANES)
+    {
+        for (int r = 0; r + MLP_ROWS <= rows; r += MLP_ROWS)
+        {
+            const float *restrict x = in + r*MLP_MAX_WIDTH;
+            __m256 a0 = _mm256_loadu_ps(bias + j), a1 = a0, a2 = a0, a3 = a0;        // MLP_ROWS rows
+            for (int i = 0; i < nIn; i++)
+            {
+                __m256 wv = _mm256_loadu_ps(w + i*nOut + j);
+                a0 = _mm256_fmadd_ps(_mm256_set1_ps(x[i]), wv, a0);
+                a1 = _mm256_fmadd_ps(_mm256_set1_ps(x[MLP_MAX_WIDTH + i]), wv, a1);
+                a2 = _mm256_fmadd_ps(_mm256_set1_ps(x[2*MLP_MAX_WIDTH + i]), wv, a2);
+                a3 = _mm256_fmadd_ps(_mm256_set1_ps(x[3*MLP_MAX_WIDTH + i]), wv, a3);
+            }
+            if (relu)                                       // max(0, a) keeps -0 and NaN like the scalar test
+            {
+                a0 = _mm256_max_ps(zero, a0); a1 = _mm256_max_ps(zero, a1);
+                a2 = _mm256_max_ps(zero, a2); a3 = _mm256_max_ps(zero, a3);
+            }
+            float *restrict o = out + r*MLP_MAX_WIDTH + j;
+            _mm256_storeu_ps(o, a0);
+            _mm256_storeu_ps(o + MLP_MAX_WIDTH, a1);
+            _mm256_storeu_ps(o + 2*MLP_MAX_WIDTH, a2);
+            _mm256_storeu_ps(o + 3*MLP_MAX_WIDTH, a3);
+        }
+    }
+    for (int r = rows/MLP_ROWS*MLP_ROWS; r < rows; r++)     // Same order of sums as the blocks above
+    {
+        const float *restrict x = in + r*MLP_MAX_WIDTH;
+        float *restrict o = out + r*MLP_MAX_WIDTH;
+        int j = 0;
+        for (; j + 4*MLP_LANES <= nOut; j += 4*MLP_LANES)  // Four slices at once, so four FMA chains overlap
+        {
+            __m256 a0 = _mm256_loadu_ps(bias + j), a1 = _mm256_loadu_ps(bias + j + MLP_LANES);
+            __m256 a2 = _mm256_loadu_ps(bias + j + 2*MLP_LANES), a3 = _mm256_loadu_ps(bias + j + 3*MLP_LANES);
+            for (int i = 0; i < nIn; i++)
+            {
+                const float *restrict wv = w + i*nOut + j;
+                __m256 xi = _mm256_set1_ps(x[i]);
+                a0 = _mm256_fmadd_ps(xi, _mm256_loadu_ps(wv), a0);
+                a1 = _mm256_fmadd_ps(xi, _mm256_loadu_ps(wv + MLP_LANES), a1);
+                a2 = _mm256_fmadd_ps(xi, _mm256_loadu_ps(wv + 2*MLP_LANES), a2);
+                a3 = _mm256_fmadd_ps(xi, _mm256_loadu_ps(wv + 3*MLP_LANES), a3);
+            }
+            if (relu)
+            {
+                a0 = _mm256_max_ps(zero, a0); a1 = _mm256_max_ps(zero, a1);
+                a2 = _mm256_max_ps(zero, a2); a3 = _mm256_max_ps(zero, a3);
+            }
+            _mm256_storeu_ps(o + j, a0);
+            _mm256_storeu_ps(o + j + MLP_LANES, a1);
+            _mm256_storeu_ps(o + j + 2*MLP_LANES, a2);
+            _mm256_storeu_ps(o + j + 3*MLP_LANES, a3);
+        }
+        for (; j < nOut; j += MLP_LANES)                    // The last few slices, one at a time
+        {
+            __m256 a = _mm256_loadu_ps(bias + j);
+            for (int i = 0; i < nIn; i++) a = _mm256_fmadd_ps(_mm256_set1_ps(x[i]), _mm256_loadu_ps(w + i*nOut + j), a);
+            _mm256_storeu_ps(o + j, relu ? _mm256_max_ps(zero, a) : a);
+        }
+    }
+}
+#endif
+
+void mlp_forward(const t_mlp *net, const float *in, float *out, int batch)
+{
+    // in: batch rows of FEATURE_COUNT floats, out: batch rows of 3 floats. Up to
+    // MLP_MAX_BATCH rows go through each layer together
+    static float a[MLP_MAX_BATCH*MLP_MAX_WIDTH], b[MLP_MAX_BATCH*MLP_MAX_WIDTH];
+    void (*layer)(const float *restrict, int, const float *restrict, const float *restrict, float *restrict, int, int, bool) = mlp_layer;
+#ifdef MLP_AVX2
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) layer = mlp_layer_avx2;  // Checked by libgcc at startup
+#endif
+    for (int first = 0; first < batch; first += MLP_MAX_BATCH)
+    {
+        int rows = (batch - first < MLP_MAX_BATCH) ? batch - first : MLP_MAX_BATCH;
+        for (int r = 0; r < rows; r++) memcpy(a + r*MLP_MAX_WIDTH, in + (first + r)*FEATURE_COUNT, FEATURE_COUNT*sizeof(float));
+        float *src = a, *dst = b;
+        for (int l = 0; l < net->layers; l++)
+        {
+            layer(src, net->width[l], net->weights[l], net->bias[l], dst, net->padded[l + 1], rows, l + 1 < net->layers);
+            float *t = src; src = dst; dst = t;
+        }
+        for (int r = 0; r < rows; r++) memcpy(out + (first + r)*3, src + r*MLP_MAX_WIDTH, 3*sizeof(float));
+    }
+}
+
+void press_policy_keys(const float out[3])
+{
+    // The policy's keys replace the player's movement/launch keys for this tick
+    unsigned int move = (1u << INPUT_LEFT) | (1u << INPUT_RIGHT);
+    input.down = (input.down & ~move) | ((out[0] > 0.0f) << INPUT_LEFT) | ((out[1] > 0.0f) << INPUT_RIGHT);
+    input.pressed = (input.pressed & ~(1u << INPUT_LAUNCH)) | ((out[2] > 0.0f) << INPUT_LAUNCH);
+}
+
+void toggle_autopilot(void)
+{
+    // Once per tick, however many games the policy is driving
+    if (attractOn) return;
+    if (input_pressed(INPUT_AUTOPILOT) && (autopilot.layers > 0 || script.length > 0)) autopilotOn = !autopilotOn;
+}
+
+void apply_autopilot(void)
+{
+    if (attractOn) return;                                  // Recorded game, its inputs are already set
+    if (!autopilotOn || gameState != GAME_PLAYING || paused) return;
+
+    float f[FEATURE_COUNT], out[3];
+    extract_features(f);
+    if (script.length > 0)                                  // A script takes precedence over a network
+    {
+        unsigned int keys = run_script(&script, f);
+        out[0] = (float)((keys >> INPUT_LEFT) & 1);
+        out[1] = (float)((keys >> INPUT_RIGHT) & 1);
+        out[2] = (float)((keys >> INPUT_LAUNCH) & 1);
+    }
+    else mlp_forward(&autopilot, f, out, 1);
+    press_policy_keys(out);
+}
+
+int autopilot_eval(int games)
+{
+    // Plays seeded games headlessly and reports how well the policy does and what it costs
+    if (autopilot.layers == 0 && script.length == 0)
+    {
+        fprintf(stderr, "autopilot: --autopilot-eval needs --autopilot <weights> or --script <file>\n");
+        return 1;
+    }
+    // A tick is far too short to time on its own, so each game is timed whole: once played by
+    // the policy, then again from the keys it pressed. The second run is the simulation alone
+    // and the difference is the policy. No window here, so startup_clock() instead of GetTime()
+    double policyTime = 0.0, stepTime = 0.0;
+    long long ticks = 0, totalScore = 0;
+    int wins = 0;
+
+    for (int g = 0; g < games; g++)
+    {
+        gameSeed = (uint32_t)g + 1;
+        init_game();
+        gameState = GAME_PLAYING;
+        int played = 0;
+        double t0 = startup_clock();
+        for (; played < REPLAY_MAX_TICKS && gameState == GAME_PLAYING; played++)
+        {
+            input = (t_input){ 0 };
+            apply_autopilot();
+            replayInputs[played] = (uint16_t)(input.down | (input.pressed << 8));
+            update_game();
+        }
+        double t1 = startup_clock();
+        totalScore += score;
+        wins += (gameState == GAME_WIN);
+
+        init_game();                                        // Same seed, same keys: the same game
+        gameState = GAME_PLAYING;
+        for (int t = 0; t < played; t++)
+        {
+            input.down = replayInputs[t] & 0xff;
+            input.pressed = replayInputs[t] >> 8;
+            update_game();
+        }
+        double t2 = startup_clock();
+        stepTime += t2 - t1;
+        policyTime += (t1 - t0) - (t2 - t1);
+        ticks += played;
+    }
+    if (policyTime < 0.0) policyTime = 0.0;                 // A policy cheaper than the timing noise
+    printf("autopilot: %d games, mean score %.1f, %d wins, %lld ticks\n", games, (games > 0) ? (double)totalScore/games : 0.0, wins, ticks);
+    if (ticks > 0) printf("autopilot: policy %.3f us/tick, simulation %.3f us/tick\n", policyTime*1e6/ticks, stepTime*1e6/ticks);
+    return 0;
+}
+
+//------------------------------------------------------------------------------------
+// Scripts - bot behaviour compiled to register bytecode (syntax in the README)
+//------------------------------------------------------------------------------------
+typedef struct s_script_compiler
+{
+    t_script *s;
+    const char *p;                   // Position in the current line
+    int line;
+    int nextTemp;                    // Temporaries count down from the top register, reset per statement
+    const char *error;               // First error, NULL while compiling cleanly
+} t_script_compiler;
+
+static int sc_expr(t_script_compiler *c);
+
+static void sc_skip(t_script_compiler *c) { while (*c->p == ' ' || *c->p == '\t' || *c->p == '\r') c->p++; }
+static bool sc_is_ident(char ch) { return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9') || ch == '_'; }
+
+static bool sc_accept(t_script_compiler *c, const char *token)
+{
+    // Words must end where the token does ("end" doesn't match "ending")
+    sc_skip(c);
+    size_t n = strlen(token);
+    if (strncmp(c->p, token, n) != 0 || (sc_is_ident(token[0]) && sc_is_ident(c->p[n]))) return false;
+    c->p += n;
+    return true;
+}
+
+static int sc_emit(t_script_compiler *c, int op, int a, int b, int cc)
+{
+    if (c->s->length >= SCRIPT_CODE_MAX) { c->error = "script too long"; return 0; }
+    c->s->code[c->s->length] = (uint32_t)op | (uint32_t)a << 8 | (uint32_t)b << 16 | (uint32_t)cc << 24;
+    return c->s->length++;
+}
+
+static void sc_patch(t_script_compiler *c, int at, int target)
+{
+    c->s->code[at] = (c->s->code[at] & 0xffff) | (uint32_t)target << 16;
+}
+
+static int sc_temp(t_script_compiler *c)
+{
+    if (c->nextTemp <= c->s->constEnd) { c->error = "expression too complex"; return SCRIPT_REGS - 1; }
+    return c->nextTemp--;
+}
+
+static int sc_const(t_script_compiler *c, float value)
+{
+    // Constants are registers filled in once at load; equal ones share a register
+    for (int r = SCRIPT_CONST_BASE; r < c->s->constEnd; r++)
+        if (c->s->regs[r] == value) return r;
+    if (c->s->constEnd > c->nextTemp) { c->error = "too many constants"; return SCRIPT_CONST_BASE; }
+    c->s->regs[c->s->constEnd] = value;
+    return c->s->constEnd++;
+}
+
+static int sc_primary(t_script_compiler *c)
+{
+    sc_skip(c);
+    if ((*c->p >= '0' && *c->p <= '9') || *c->p == '.')
+    {
+        char *end;
+        float value = strtof(c->p, &end);
+        c->p = end;
+        return sc_const(c, value);
+    }
+    if (sc_accept(c, "("))
+    {
+        int r = sc_expr(c);
+        if (!sc_accept(c, ")")) c->error = "missing )";
+        return r;
+    }
+
+    char name[SCRIPT_NAME_MAX];
+    int n = 0;
+    while (sc_is_ident(*c->p) && n < SCRIPT_NAME_MAX - 1) name[n++] = *c->p++;
+    name[n] = '\0';
+    if (n == 0) { c->error = "expected a value"; return 0; }
+
+    static const struct { const char *name; int op, args; } functions[] = {
+        { "abs", SCRIPT_ABS, 1 }, { "min", SCRIPT_MIN, 2 }, { "max", SCRIPT_MAX, 2 }
+    };
+    for (size_t f = 0; f < sizeof(functions)/sizeof(functions[0]); f++)
+    {
+        if (strcmp(name, functions[f].name) != 0) continue;
+        if (!sc_accept(c, "(")) { c->error = "missing ( after function"; return 0; }
+        int a = sc_expr(c), b = a;
+        if (functions[f].args == 2 && !sc_accept(c, ",")) { c->error = "function needs two arguments"; return 0; }
+        if (functions[f].args == 2) b = sc_expr(c);
+        if (!sc_accept(c, ")")) { c->error = "missing )"; return 0; }
+        int t = sc_temp(c);
+        sc_emit(c, functions[f].op, t, a, b);
+        return t;
+    }
+    for (int f = 0; f < FEATURE_COUNT; f++)                 // Game state: read-only registers
+        if (strcmp(name, featureNames[f]) == 0) return f;
+    for (int v = 0; v < c->s->vars; v++)
+        if (strcmp(name, c->s->varNames[v]) == 0) return SCRIPT_VAR_BASE + v;
+    c->error = "unknown name";
+    return 0;
+}
+
+static int sc_unary(t_script_compiler *c)
+{
+    int op = sc_accept(c, "-") ? SCRIPT_NEG : sc_accept(c, "not") ? SCRIPT_NOT : -1;
+    int r = (op < 0) ? sc_primary(c) : sc_unary(c);
+    if (op < 0) return r;
+    int t = sc_temp(c);
+    sc_emit(c, op, t, r, 0);
+    return t;
+}
+
+static int sc_binary(t_script_compiler *c, int level)
+{
+    // Lowest to highest precedence: or, and, comparisons, + -, * /
+    static const struct { const char *token; int op; bool swap; } ops[5][6] = {
+        { { "or", SCRIPT_OR, false } },
+        { { "and", SCRIPT_AND, false } },
+        { { "<=", SCRIPT_LE, false }, { ">=", SCRIPT_LE, true }, { "<", SCRIPT_LT, false },
+          { ">", SCRIPT_LT, true }, { "==", SCRIPT_EQ, false }, { "!=", SCRIPT_NE, false } },
+        { { "+", SCRIPT_ADD, false }, { "-", SCRIPT_SUB, false } },
+        { { "*", SCRIPT_MUL, false }, { "/", SCRIPT_DIV, false } }
+    };
+    if (level == 5) return sc_unary(c);
+    int left = sc_binary(c, level + 1);
+    for (int i = 0; i < 6 && ops[level][i].token != NULL && c->error == NULL; i++)
+    {
+        if (!sc_accept(c, ops[level][i].token)) continue;
+        int right = sc_binary(c, level + 1), t = sc_temp(c);
+        if (ops[level][i].swap) sc_emit(c, ops[level][i].op, t, right, left);   // a > b is b < a
+        else sc_emit(c, ops[level][i].op, t, left, right);
+        left = t;
+        i = -1;                                              // Left-associative: look for another
+    }
+    return left;
+}
+
+static int sc_expr(t_script_compiler *c) { return sc_binary(c, 0); }
+
+static void sc_statement(t_script_compiler *c, int blocks[SCRIPT_DEPTH][SCRIPT_EXITS + 2], int *depth)
+{
+    // blocks[d]: [0] pending jump to the next branch (-1 none), [1] exits so far, [2..] jumps to end
+    int *block = (*depth > 0) ? blocks[*depth - 1] : NULL;
+    bool elif = (block != NULL && sc_accept(c, "elif"));
+    if (elif || sc_accept(c, "if"))
+    {
+        if (elif)
+        {
+            if (block[0] < 0) { c->error = "elif after else"; return; }
+            if (block[1] == SCRIPT_EXITS) { c->error = "too many elif"; return; }
+            block[2 + block[1]++] = sc_emit(c, SCRIPT_JMP, 0, 0, 0);
+            sc_patch(c, block[0], c->s->length);
+        }
+        else
+        {
+            if (*depth == SCRIPT_DEPTH) { c->error = "ifs nested too deep"; return; }
+            block = blocks[(*depth)++];
+            block[1] = 0;
+        }
+        block[0] = sc_emit(c, SCRIPT_JZ, sc_expr(c), 0, 0);
+    }
+    else if (block != NULL && sc_accept(c, "else"))
+    {
+        if (block[0] < 0) { c->error = "second else"; return; }
+        if (block[1] == SCRIPT_EXITS) { c->error = "too many elif"; return; }
+        block[2 + block[1]++] = sc_emit(c, SCRIPT_JMP, 0, 0, 0);
+        sc_patch(c, block[0], c->s->length);
+        block[0] = -1;
+    }
+    else if (block != NULL && sc_accept(c, "end"))
+    {
+        if (block[0] >= 0) sc_patch(c, block[0], c->s->length);
+        for (int e = 0; e < block[1]; e++) sc_patch(c, block[2 + e], c->s->length);
+        (*depth)--;
+    }
+    else if (sc_accept(c, "left")) sc_emit(c, SCRIPT_KEY, INPUT_LEFT, 0, 0);
+    else if (sc_accept(c, "right")) sc_emit(c, SCRIPT_KEY, INPUT_RIGHT, 0, 0);
+    else if (sc_accept(c, "launch")) sc_emit(c, SCRIPT_KEY, INPUT_LAUNCH, 0, 0);
+    else
+    {
+        // name = expr; a new name becomes a variable that keeps its value between ticks
+        const char *start = c->p;
+        while (sc_is_ident(*c->p)) c->p++;
+        int n = (int)(c->p - start), var = -1;
+        if (n == 0 || n >= SCRIPT_NAME_MAX || (*start >= '0' && *start <= '9') || !sc_accept(c, "="))
+        {
+            c->error = "expected a statement";
+            return;
+        }
+        for (int f = 0; f < FEATURE_COUNT; f++)
+            if ((int)strlen(featureNames[f]) == n && strncmp(start, featureNames[f], n) == 0) { c->error = "game state is read-only"; return; }
+        for (int v = 0; v < c->s->vars && var < 0; v++)
+            if ((int)strlen(c->s->varNames[v]) == n && strncmp(start, c->s->varNames[v], n) == 0) var = v;
+        if (var < 0 && c->s->vars == SCRIPT_VARS) { c->error = "too many variables"; return; }
+        if (var < 0)
+        {
+            var = c->s->vars++;
+            memcpy(c->s->varNames[var], start, n);
+            c->s->varNames[var][n] = '\0';
+        }
+        int before = c->s->length, r = sc_expr(c);
+        uint32_t *last = &c->s->code[c->s->length > 0 ? c->s->length - 1 : 0];
+        if (c->s->length > before && (int)((*last >> 8) & 0xff) == r && r > c->nextTemp)
+            *last = (*last & ~0xff00u) | (uint32_t)(SCRIPT_VAR_BASE + var) << 8;   // Result straight into the variable
+        else sc_emit(c, SCRIPT_MOV, SCRIPT_VAR_BASE + var, r, 0);
+    }
+}
+
+bool load_script(t_script *s, const char *path)
+{
+    FILE *file = fopen(path, "r");
+    if (file == NULL) { fprintf(stderr, "script: can't open %s\n", path); return false; }
+
+    memset(s, 0, sizeof(*s));
+    s->constEnd = SCRIPT_CONST_BASE;
+    t_script_compiler c = { s, NULL, 0, SCRIPT_REGS - 1, NULL };
+    int blocks[SCRIPT_DEPTH][SCRIPT_EXITS + 2], depth = 0;
+    char text[SCRIPT_LINE_MAX];
+    while (c.error == NULL && fgets(text, sizeof(text), file) != NULL)
+    {
+        c.line++;
+        c.p = text;
+        c.nextTemp = SCRIPT_REGS - 1;
+        sc_skip(&c);
+        if (*c.p != '\n' && *c.p != '#' && *c.p != '\0') sc_statement(&c, blocks, &depth);
+        sc_skip(&c);
+        if (c.error == NULL && *c.p != '\n' && *c.p != '#' && *c.p != '\0') c.error = "unexpected text after statement";
+    }
+    fclose(file);
+    if (c.error == NULL && depth > 0) c.error = "missing end";
+    sc_emit(&c, SCRIPT_HALT, 0, 0, 0);
+    if (c.error != NULL)
+    {
+        fprintf(stderr, "script: %s:%d: %s\n", path, c.line, c.error);
+        memset(s, 0, sizeof(*s));
+        return false;
+    }
+    return true;
+}
+
+unsigned int run_script(t_script *s, const float *features)
+{
+    // Straight-line code with forward jumps only, so a run is bounded by the script's length.
+    // Dispatch jumps straight from one handler to the next (GCC/Clang), else a switch
+    float *r = s->regs;
+    const uint32_t *pc = s->code;
+    uint32_t ins;
+    unsigned int keys = 0;
+    memcpy(r, features, FEATURE_COUNT*sizeof(float));
+#define RA r[(ins >> 8) & 0xff]
+#define RB r[(ins >> 16) & 0xff]
+#define RC r[ins >> 24]
+#if defined(__GNUC__)
+#define VM_OP(op)      vm_##op
+#define VM_NEXT()      goto *dispatch[(ins = *pc++) & 0xff]
+    static const void *dispatch[SCRIPT_OP_COUNT] = {
+        [SCRIPT_MOV] = &&vm_SCRIPT_MOV, [SCRIPT_ADD] = &&vm_SCRIPT_ADD, [SCRIPT_SUB] = &&vm_SCRIPT_SUB,
+        [SCRIPT_MUL] = &&vm_SCRIPT_MUL, [SCRIPT_DIV] = &&vm_SCRIPT_DIV, [SCRIPT_LT] = &&vm_SCRIPT_LT,
+        [SCRIPT_LE] = &&vm_SCRIPT_LE, [SCRIPT_EQ] = &&vm_SCRIPT_EQ, [SCRIPT_NE] = &&vm_SCRIPT_NE,
+        [SCRIPT_AND] = &&vm_SCRIPT_AND, [SCRIPT_OR] = &&vm_SCRIPT_OR, [SCRIPT_NOT] = &&vm_SCRIPT_NOT,
+        [SCRIPT_NEG] = &&vm_SCRIPT_NEG, [SCRIPT_ABS] = &&vm_SCRIPT_ABS, [SCRIPT_MIN] = &&vm_SCRIPT_MIN,
+        [SCRIPT_MAX] = &&vm_SCRIPT_MAX, [SCRIPT_JMP] = &&vm_SCRIPT_JMP, [SCRIPT_JZ] = &&vm_SCRIPT_JZ,
+        [SCRIPT_KEY] = &&vm_SCRIPT_KEY, [SCRIPT_HALT] = &&vm_SCRIPT_HALT
+    };
+    VM_NEXT();
+#else
+#define VM_OP(op)      case op
+#define VM_NEXT()      continue
+    for (;;) switch ((ins = *pc++) & 0xff) {
+#endif
+    VM_OP(SCRIPT_MOV): RA = RB; VM_NEXT();
+    VM_OP(SCRIPT_ADD): RA = RB + RC; VM_NEXT();
+    VM_OP(SCRIPT_SUB): RA = RB - RC; VM_NEXT();
+    VM_OP(SCRIPT_MUL): RA = RB*RC; VM_NEXT();
+    VM_OP(SCRIPT_DIV): RA = (RC != 0.0f) ? RB/RC : 0.0f; VM_NEXT();   // x/0 is 0, never inf/NaN
+    VM_OP(SCRIPT_LT):  RA = (float)(RB < RC); VM_NEXT();
+    VM_OP(SCRIPT_LE):  RA = (float)(RB <= RC); VM_NEXT();
+    VM_OP(SCRIPT_EQ):  RA = (float)(RB == RC); VM_NEXT();
+    VM_OP(SCRIPT_NE):  RA = (float)(RB != RC); VM_NEXT();
+    VM_OP(SCRIPT_AND): RA = (float)(RB != 0.0f && RC != 0.0f); VM_NEXT();
+    VM_OP(SCRIPT_OR):  RA = (float)(RB != 0.0f || RC != 0.0f); VM_NEXT();
+    VM_OP(SCRIPT_NOT): RA = (float)(RB == 0.0f); VM_NEXT();
+    VM_OP(SCRIPT_NEG): RA = -RB; VM_NEXT();
+    VM_OP(SCRIPT_ABS): RA = fabsf(RB); VM_NEXT();
+    VM_OP(SCRIPT_MIN): RA = (RB < RC) ? RB : RC; VM_NEXT();
+    VM_OP(SCRIPT_MAX): RA = (RB > RC) ? RB : RC; VM_NEXT();
+    VM_OP(SCRIPT_JMP): pc = s->code + (ins >> 16); VM_NEXT();
+    VM_OP(SCRIPT_JZ):  if (RA == 0.0f) pc = s->code + (ins >> 16); VM_NEXT();
+    VM_OP(SCRIPT_KEY): keys |= 1u << ((ins >> 8) & 0xff); VM_NEXT();
+    VM_OP(SCRIPT_HALT): return keys;
+#if !defined(__GNUC__)
+    }
+#endif
+#undef VM_NEXT
+#undef VM_OP
+#undef RC
+#undef RB
+#undef RA
+}
+
+//------------------------------------------------------------------------------------
+// Metrics - Prometheus text over a Unix socket, served from its own thread
+//------------------------------------------------------------------------------------
+void publish_metrics(double frameSeconds)
+{
+    // Plain stores only: the frame loop never waits on (or even notices) a scrape
+    if (metricsPath == NULL) return;
+    unsigned int ballsActive = 0, powerupsActive = 0;
+    for (int b = 0; b < BALLS_MAX; b++) ballsActive += balls[b].active;
+    for (int i = 0; i < POWERUPS_MAX; i++) powerupsActive += powerups[i].active;
+
+    unsigned int frame = metrics.frames, frameUs = (unsigned int)(frameSeconds*1e6);
+    ATOMIC_STORE(&metrics.frameUs[frame & (METRICS_WINDOW - 1)], frameUs);
+    ATOMIC_STORE(&metrics.frames, frame + 1);
+    ATOMIC_STORE(&metrics.balls, ballsActive);
+    ATOMIC_STORE(&metrics.powerups, powerupsActive);
+    ATOMIC_STORE(&metrics.bricks, (unsigned int)bricksLeft);
+    ATOMIC_STORE(&metrics.state, (unsigned int)gameState);
+
+    // Totals go to the slot a reader of the current totalsFrame isn't using, then totalsFrame
+    // moves on; a reader that sees it move while copying just copies again
+    metrics.frameUsSum += frameUs;
+    unsigned int next = metrics.totalsFrame + 1;
+    t_metrics_totals *t = &metrics.totals[next & 1];
+    ATOMIC_STORE(&t->frames, frame + 1);
+    ATOMIC_STORE(&t->ticks, metrics.ticks);
+    ATOMIC_STORE(&t->frameUsLow, (unsigned int)metrics.frameUsSum);
+    ATOMIC_STORE(&t->frameUsHigh, (unsigned int)(metrics.frameUsSum >> 32));
+    ATOMIC_STORE(&t->tickNsLow, (unsigned int)metrics.tickNsSum);
+    ATOMIC_STORE(&t->tickNsHigh, (unsigned int)(metrics.tickNsSum >> 32));
+    ATOMIC_STORE(&metrics.totalsFrame, next);
+}
+
+void publish_tick(double tickSeconds)
+{
+    // Its totals reach the metrics thread with the next frame's
+    if (metricsPath == NULL) return;
+    unsigned int tick = metrics.ticks, tickNs = (unsigned int)(tickSeconds*1e9);
+    ATOMIC_STORE(&metrics.tickNs[tick & (METRICS_WINDOW - 1)], tickNs);
+    ATOMIC_STORE(&metrics.ticks, tick + 1);
+    metrics.tickNsSum += tickNs;
+}
+
+#ifndef _WIN32
+static int compare_uint(const void *a, const void *b)
+{
+    unsigned int x = *(const unsigned int *)a, y = *(const unsigned int *)b;
+    return (x > y) - (x < y);
+}
+
+static int format_metrics(char *out, int size)
+{
+    // Snapshot the rings (a slot may be one frame newer than `frames`; that's fine for percentiles)
+    static unsigned int frameUs[METRICS_WINDOW], tickNs[METRICS_WINDOW];
+    unsigned int frames = ATOMIC_LOAD(&metrics.frames), ticks = ATOMIC_LOAD(&metrics.ticks);
+    int nFrames = (frames < METRICS_WINDOW) ? (int)frames : METRICS_WINDOW;
+    int nTicks = (ticks < METRICS_WINDOW) ? (int)ticks : METRICS_WINDOW;
+    double frameSum = 0.0;
+    for (int i = 0; i < nFrames; i++) { frameUs[i] = ATOMIC_LOAD(&metrics.frameUs[i]); frameSum += frameUs[i]; }
+    for (int i = 0; i < nTicks; i++) tickNs[i] = ATOMIC_LOAD(&metrics.tickNs[i]);
+    qsort(frameUs, nFrames, sizeof(unsigned int), compare_uint);
+    qsort(tickNs, nTicks, sizeof(unsigned int), compare_uint);
+
+    // _sum and _count cover the whole run (only the quantiles are windowed), copied consistently
+    t_metrics_totals totals;
+    unsigned int totalsFrame;
+    do
+    {
+        totalsFrame = ATOMIC_LOAD(&metrics.totalsFrame);
+        const t_metrics_totals *t = &metrics.totals[totalsFrame & 1];
+        totals.frames = ATOMIC_LOAD(&t->frames);
+        totals.ticks = ATOMIC_LOAD(&t->ticks);
+        totals.frameUsLow = ATOMIC_LOAD(&t->frameUsLow);
+        totals.frameUsHigh = ATOMIC_LOAD(&t->frameUsHigh);
+        totals.tickNsLow = ATOMIC_LOAD(&t->tickNsLow);
+        totals.tickNsHigh = ATOMIC_LOAD(&t->tickNsHigh);
+    } while (ATOMIC_LOAD(&metrics.totalsFrame) != totalsFrame);
+    double frameUsTotal = (double)(((uint64_t)totals.frameUsHigh << 32) | totals.frameUsLow);
+    double tickNsTotal = (double)(((uint64_t)totals.tickNsHigh << 32) | totals.tickNsLow);
+
+    static const char *stateNames[] = { "title", "playing", "over", "win" };
+    unsigned int state = ATOMIC_LOAD(&metrics.state);
+    static const double quantiles[] = { 0.5, 0.9, 0.99 };
+    int n = 0;
+
+    n += snprintf(out + n, size - n,
+        "# HELP arkanoid_fps Frames per second over the last %d frames.\n# TYPE arkanoid_fps gauge\n"
+        "arkanoid_fps %.2f\n", METRICS_WINDOW, (frameSum > 0.0) ? nFrames*1e6/frameSum : 0.0);
+    n += snprintf(out + n, size - n, "# HELP arkanoid_frame_seconds Frame time.\n# TYPE arkanoid_frame_seconds summary\n");
+    for (int q = 0; q < 3 && nFrames > 0; q++)
+        n += snprintf(out + n, size - n, "arkanoid_frame_seconds{quantile=\"%g\"} %.6f\n",
+                      quantiles[q], frameUs[(int)(quantiles[q]*(nFrames - 1))]*1e-6);
+    n += snprintf(out + n, size - n, "arkanoid_frame_seconds_sum %.6f\narkanoid_frame_seconds_count %u\n", frameUsTotal*1e-6, totals.frames);
+    n += snprintf(out + n, size - n, "# HELP arkanoid_tick_seconds Simulation cost of one tick.\n# TYPE arkanoid_tick_seconds summary\n");
+    for (int q = 0; q < 3 && nTicks > 0; q++)
+        n += snprintf(out + n, size - n, "arkanoid_tick_seconds{quantile=\"%g\"} %.9f\n",
+                      quantiles[q], tickNs[(int)(quantiles[q]*(nTicks - 1))]*1e-9);
+    n += snprintf(out + n, size - n, "arkanoid_tick_seconds_sum %.9f\narkanoid_tick_seconds_count %u\n", tickNsTotal*1e-9, totals.ticks);
+    n += snprintf(out + n, size - n,
+        "# TYPE arkanoid_frames_total counter\narkanoid_frames_total %u\n"
+        "# TYPE arkanoid_ticks_total counter\narkanoid_ticks_total %u\n"
+        "# TYPE arkanoid_balls gauge\narkanoid_balls %u\n"
+        "# TYPE arkanoid_powerups gauge\narkanoid_powerups %u\n"
+        "# TYPE arkanoid_bricks_live gauge\narkanoid_bricks_live %u\n"
+        "# HELP arkanoid_game_state 1 for the screen currently shown.\n# TYPE arkanoid_game_state gauge\n",
+        frames, ticks, ATOMIC_LOAD(&metrics.balls), ATOMIC_LOAD(&metrics.powerups), ATOMIC_LOAD(&metrics.bricks));
+    for (unsigned int i = 0; i < 4; i++)
+        n += snprintf(out + n, size - n, "arkanoid_game_state{state=\"%s\"} %d\n", stateNames[i], state == i);
+    return (n < size) ? n : size - 1;
+}
+
+static void *metrics_main(void *arg)
+{
+    (void)arg;
+    static char body[8192], head[128];
+    for (;;)
+    {
+        int client = accept(metricsSocket, NULL, NULL);
+        if (client < 0) break;                               // stop_metrics() shut the socket down
+
+        // Answer as HTTP so `curl --unix-socket` and scrape proxies work; the request itself is ignored
+        struct timeval timeout = { 0, 200000 };
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        char request[1024];
+        recv(client, request, sizeof(request), 0);           // Bare connections (socat) time out, then get answered
+
+        int length = format_metrics(body, sizeof(body));
+        int headLength = snprintf(head, sizeof(head), "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"
+                                  "Content-Length: %d\r\n\r\n", length);
+        send(client, head, headLength, MSG_NOSIGNAL);        // A scraper that hung up mustn't SIGPIPE the game
+        send(client, body, length, MSG_NOSIGNAL);
+        close(client);
+    }
+    return NULL;
+}
+#endif
+
+void start_metrics(void)
+{
+#ifndef _WIN32
+    if (metricsPath == NULL) return;
+    struct sockaddr_un addr = { 0 };
+    addr.sun_family = AF_UNIX;
+    if (strlen(metricsPath) >= sizeof(addr.sun_path)) { fprintf(stderr, "metrics: socket path too long\n"); metricsPath = NULL; return; }
+    strcpy(addr.sun_path, metricsPath);
+    unlink(metricsPath);                                     // Left over from a previous run
+
+    metricsSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (metricsSocket < 0 || bind(metricsSocket, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(metricsSocket, 4) != 0 || pthread_create(&metricsThread, NULL, metrics_main, NULL) != 0)
+    {
+        fprintf(stderr, "metrics: can't serve on %s\n", metricsPath);
+        if (metricsSocket >= 0) close(metricsSocket);
+        metricsSocket = -1;
+        metricsPath = NULL;                                  // Keeps publish_metrics() a no-op
+    }
+#else
+    metricsPath = NULL;                                      // No Unix sockets here
+#endif
+}
+
+void stop_metrics(void)
+{
+#ifndef _WIN32
+    if (metricsSocket < 0) return;
+    shutdown(metricsSocket, SHUT_RDWR);                      // Wakes accept() so the thread can finish
+    pthread_join(metricsThread, NULL);
+    close(metricsSocket);
+    unlink(metricsPath);
+    metricsSocket = -1;
+#endif
+}
+
+//------------------------------------------------------------------------------------
+// Flight recorder - recent frame timings and events, dumped to disk when a frame runs long
+//------------------------------------------------------------------------------------
+void flight_event(t_flight_kind kind, unsigned int arg)
+{
+    if (rewindReplaying) return;
+    t_flight_entry *e = &flightRing[flightHead++ & (FLIGHT_RING - 1)];
+    e->time = simTime;
+    e->kind = kind;
+    e->arg = arg;
+}
+
+static void write_flight_dump(void)
+{
+    // Runs on the dump thread: everything it reads was copied before flightDumpBusy was set
+    char path[512];
+    const t_flight_snapshot *snap = &flightSnapshot;
+    snprintf(path, sizeof(path), "%s/hitch-%ld-%.0f.txt", flightDir, (long)time(NULL), snap->time*1e3);
+    FILE *file = fopen(path, "w");
+    if (file == NULL) { fprintf(stderr, "flight: can't write %s\n", path); return; }
+
+    static const char *kindNames[] = { "frame", "state", "paddle", "brick", "ball_lost", "powerup" };
+    fprintf(file, "# hitch: %.2f ms frame (budget %.2f ms) at t=%.4f\n", snap->hitchMs, hitchMs, snap->time);
+    fprintf(file, "state %d score %d lives %d bricks_left %d seed %u level %s\n", snap->state, snap->score,
+            snap->player.life, snap->bricksLeft, snap->seed, snap->level);
+    fprintf(file, "paddle %.1f %.1f %.1f %.1f\n", snap->player.pos.x, snap->player.pos.y, snap->player.size.x, snap->player.size.y);
+    for (int b = 0; b < BALLS_MAX; b++)
+        if (snap->balls[b].active)
+            fprintf(file, "ball %d pos %.1f %.1f spd %.2f %.2f\n", b, snap->balls[b].pos.x, snap->balls[b].pos.y,
+                    snap->balls[b].spd.x, snap->balls[b].spd.y);
+    for (int i = 0; i < POWERUPS_MAX; i++)
+        if (snap->powerups[i].active)
+            fprintf(file, "powerup %d type %d pos %.1f %.1f\n", i, snap->powerups[i].type,
+                    snap->powerups[i].pos.x, snap->powerups[i].pos.y);
+
+    fprintf(file, "# oldest first; frame: update draw present wait (ms)\n");
+    unsigned int count = (flightDumpHead < FLIGHT_RING) ? flightDumpHead : FLIGHT_RING;
+    for (unsigned int n = flightDumpHead - count; n != flightDumpHead; n++)
+    {
+        const t_flight_entry *e = &flightDump[n & (FLIGHT_RING - 1)];
+        if (e->kind == FLIGHT_FRAME)
+            fprintf(file, "%.4f frame %.3f %.3f %.3f %.3f\n", e->time, e->ms[0], e->ms[1], e->ms[2], e->ms[3]);
+        else
+            fprintf(file, "%.4f %s %u\n", e->time, kindNames[e->kind], e->arg);
+    }
+    fclose(file);
+}
+
+#ifndef _WIN32
+static void *flight_main(void *arg)
 {
-    Rectangle rect;                  // Rectangle for brick position/size
-    bool active;                     // Is brick still visible (true), or destroyed (false)
-} t_brick;
+    (void)arg;
+    for (;;)
+    {
+        while (sem_wait(&flightWake) != 0) { }              // Interrupted by a signal: keep waiting
+        if (!flightThreadRunning) break;
+        write_flight_dump();
+        ATOMIC_STORE(&flightDumpBusy, 0);
+    }
+    return NULL;
+}
+#endif
 
-typedef struct s_powerup
+void flight_frame(double start, const float ms[4])
 {
-    Vector2 pos;                     // Powerup position (center x, y)
-    Vector2 spd;                     // Powerup falling speed (y only)
-    t_powerup_type type;             // Which powerup this is (expand, life, multi-ball)
-    bool active;                     // Is powerup still falling/visible
-} t_powerup;
+    t_flight_entry *e = &flightRing[flightHead++ & (FLIGHT_RING - 1)];
+    e->time = start;
+    e->kind = FLIGHT_FRAME;
+    e->arg = 0;
+    memcpy(e->ms, ms, sizeof(e->ms));
 
-//------------------------------------------------------------------------------------
-// Global Variables - accessible everywhere in file for game state
-//------------------------------------------------------------------------------------
-static const int screenWidth = 960;         // Game window pixel width
-static const int screenHeight = 720;        // Game window pixel height
+    float total = ms[0] + ms[1] + ms[2] + ms[3];
+    if (total <= hitchMs || start - lastDumpTime < FLIGHT_DUMP_GAP) return;
+    if (ATOMIC_LOAD(&flightDumpBusy)) return;               // Still writing the last one; this hitch is in the next
 
-static t_player player = { 0 };             // One player struct, initialized to all zeros
-static t_ball balls[BALLS_MAX] = { 0 };     // Array of all possible balls (max BALLS_MAX)
-static int ballsCount = 1;                  // Current number of balls active/in play
-static t_brick bricks[LINES_OF_BRICKS][BRICKS_PER_LINE] = { 0 }; // 2D array of bricks
-static Vector2 brickSize = { 0 };           // Size of each brick calculated at runtime
-static t_gamestate gameState = GAME_TITLE;  // Overall game state (starts at title screen)
-static bool pause = false;                  // Is the game currently paused?
-static int score = 0;                       // Player score (starts at 0)
-static t_powerup powerups[POWERUPS_MAX] = { 0 }; // Array of possible falling powerups
-static bool waiting_for_launch = true;      // Between life loss and ball ready for relaunch
+    // Copying 128 KB is the only cost on the frame loop; formatting and file I/O happen on the dump thread
+    lastDumpTime = start;
+    memcpy(flightDump, flightRing, sizeof(flightRing));
+    flightDumpHead = flightHead;
+    flightSnapshot.time = start;
+    flightSnapshot.hitchMs = total;
+    flightSnapshot.state = gameState;
+    flightSnapshot.score = score;
+    flightSnapshot.bricksLeft = bricksLeft;
+    flightSnapshot.seed = gameSeed;
+    flightSnapshot.player = player;
+    memcpy(flightSnapshot.balls, balls, sizeof(balls));
+    memcpy(flightSnapshot.powerups, powerups, sizeof(powerups));
+    snprintf(flightSnapshot.level, sizeof(flightSnapshot.level), "%s", (levelPath != NULL) ? levelPath : "(default)");
+#ifndef _WIN32
+    if (flightThreadRunning)
+    {
+        ATOMIC_STORE(&flightDumpBusy, 1);
+        sem_post(&flightWake);
+        return;
+    }
+#endif
+    write_flight_dump();                                    // No dump thread: write it here
+}
 
-//------------------------ ------------------------------------------------------------
-// Function Prototypes - tells compiler what functions exist below
-//------------------------------------------------------------------------------------
-void   init_game(void);                    // Sets up all game variables for new game/start
-void   update_game(void);                  // Steps game logic according to game state
-void   draw_game(void);                    // Draws all objects depending on game state
-void   update_draw_frame(void);            // Calls update/draw per frame
-void   spawn_powerup(Vector2 pos);         // Creates a powerup object at brick coords
-void   apply_powerup(t_powerup_type type); // Applies effect of collected powerup
-void   reset_balls(Vector2 pos);           // Resets all balls after loss
+void start_flight_recorder(void)
+{
+#ifndef _WIN32
+    if (flightDir == NULL) return;
+    flightThreadRunning = sem_init(&flightWake, 0, 0) == 0;
+    if (flightThreadRunning && pthread_create(&flightThread, NULL, flight_main, NULL) != 0)
+    {
+        sem_destroy(&flightWake);
+        flightThreadRunning = false;
+    }
+#endif
+}
+
+void stop_flight_recorder(void)
+{
+#ifndef _WIN32
+    if (!flightThreadRunning) return;
+    while (ATOMIC_LOAD(&flightDumpBusy)) WaitTime(0.001);  // Let a dump in progress finish
+    flightThreadRunning = false;
+    sem_post(&flightWake);
+    pthread_join(flightThread, NULL);
+    sem_destroy(&flightWake);
+#endif
+}
 
 //------------------------------------------------------------------------------------
-// Main Entry Point
+// Log - binary records (message ID + raw arguments), written by a thread, formatted offline
 //------------------------------------------------------------------------------------
-int main(void)
+void log_msg(t_log_msg msg, ...)
 {
-    InitWindow(screenWidth, screenHeight, "Arkanoid "); // Creates window
-    
-    SetTargetFPS(60);                                        // Runs at 60 frames/second
-    srand((unsigned int)time(0));                            // Seeds RNG for randomness
-    init_game();                                             // Sets up all variables and objects
+    // A few stores into the ring: cheap enough to leave on in update_game()
+    if (logFile == NULL || rewindReplaying) return;
+    t_log_ring *ring = &gameLog;
+    if (ring->head - ATOMIC_LOAD(&ring->tail) >= LOG_RING) { ring->dropped++; return; }
 
-    
-    while (!WindowShouldClose())                             // Main game loop; exits when window closes
+    t_log_record *r = &ring->records[ring->head & (LOG_RING - 1)];
+    memset(r, 0, sizeof(*r));                               // Unused arguments and padding go out as zeros
+    r->time = simTime;
+    r->msg = (uint16_t)msg;
+    r->argc = 0;
+    va_list ap;
+    va_start(ap, msg);
+    for (const char *a = logMessages[msg].args; *a != '\0' && r->argc < LOG_MAX_ARGS; a++)
     {
-        update_draw_frame();                                 // Updates and draws this frame
+        if (*a == 'f') { float f = (float)va_arg(ap, double); memcpy(&r->args[r->argc++], &f, 4); }
+        else r->args[r->argc++] = (uint32_t)va_arg(ap, int);
     }
-
-    // Call cleanup (if needed)
-    CloseWindow();                                           // Close window and terminate
-    return 0;                                                // Exit with code 0 (success)
+    va_end(ap);
+    ATOMIC_STORE(&ring->head, ring->head + 1);
 }
 
-//------------------------------------------------------------------------------------
-// Module Functions - major building blocks
-//------------------------------------------------------------------------------------
-void init_game(void)
+static void drain_log(t_log_ring *ring)
 {
-    // Calculate brick size based on screen width and number of bricks per line
-    brickSize = (Vector2){ screenWidth/(float)BRICKS_PER_LINE, 38 };
+    // Consumer side: whole contiguous runs of the ring go out in one fwrite
+    unsigned int head = ATOMIC_LOAD(&ring->head), tail = ring->tail;
+    while (tail != head)
+    {
+        unsigned int start = tail & (LOG_RING - 1);
+        unsigned int run = LOG_RING - start;
+        if (run > head - tail) run = head - tail;
+        fwrite(&ring->records[start], sizeof(t_log_record), run, logFile);
+        tail += run;
+        ATOMIC_STORE(&ring->tail, tail);
+    }
+    fflush(logFile);
+}
 
-    // Initialize player (paddle)
-    player.size = (Vector2){ 140, 22 };                          // Paddle width/height
-    player.pos = (Vector2){ screenWidth/2.0f - player.size.x/2, screenHeight - 50 }; // Center & offset paddle near bottom
-    player.life = PLAYER_MAX_LIFE;                               // Set lives to max value
-    player.speed = 15.0f;                                         // Set left/right paddle movement speed
-    player.expanded = false;                                     // Not expanded at start
-    player.expand_timer = 0.0f;                                  // No expansion timer at start
+#ifndef _WIN32
+static void *log_main(void *arg)
+{
+    (void)arg;
+    for (;;)
+    {
+        while (sem_wait(&logWake) != 0) { }
+        drain_log(&gameLog);
+        if (!logThreadRunning) break;
+    }
+    return NULL;
+}
+#endif
 
-    // Initialize balls
-    for (int i = 0; i < BALLS_MAX; i++) balls[i].active = false; // All balls inactive at first
-    ballsCount = 1;                                              // Start with only 1 ball available
-    balls[0].radius = 12;                                        // Standard ball size
-    balls[0].pos = (Vector2){ player.pos.x + player.size.x/2, player.pos.y - balls[0].radius - 2 }; // Ball starts above paddle
-    balls[0].spd = (Vector2){ 0, 0 };                            // Ball doesn't move until launched
-    balls[0].active = false;                                     // Ball at rest initially
+void flush_log(void)
+{
+    if (logFile == NULL) return;
+#ifndef _WIN32
+    if (logThreadRunning) { sem_post(&logWake); return; }
+#endif
+    drain_log(&gameLog);                                    // No writer thread: write it here
+}
 
-    // Initialize bricks
-    for (int y = 0; y < LINES_OF_BRICKS; y++)
+void start_log(void)
+{
+    // File: "ARKL", version, message count, each message's format and argument letters
+    // (uint16 length + bytes), then t_log_record after t_log_record
+    if (logPath == NULL) return;
+    logFile = fopen(logPath, "wb");
+    if (logFile == NULL) { fprintf(stderr, "log: can't write %s\n", logPath); return; }
+    uint32_t head[3] = { 0, LOG_VERSION, LOG_MESSAGE_COUNT };
+    memcpy(head, "ARKL", 4);
+    fwrite(head, sizeof(head), 1, logFile);
+    for (int m = 0; m < LOG_MESSAGE_COUNT; m++)
     {
-        for (int x = 0; x < BRICKS_PER_LINE; x++)
+        const char *text[2] = { logMessages[m].format, logMessages[m].args };
+        for (int t = 0; t < 2; t++)
         {
-            bricks[y][x].rect = (Rectangle){
-                x * brickSize.x + 7,                    // X position (with left margin)
-                y * brickSize.y + 70,                   // Y position (with top margin)
-                brickSize.x - 12,                       // Brick width (with padding)
-                brickSize.y - 10                        // Brick height (with padding)
-            };
-            bricks[y][x].active = true;                 // Mark all bricks as visible and undestroyed
+            uint16_t length = (uint16_t)strlen(text[t]);
+            fwrite(&length, 2, 1, logFile);
+            fwrite(text[t], 1, length, logFile);
         }
     }
+#ifndef _WIN32
+    logThreadRunning = sem_init(&logWake, 0, 0) == 0;
+    if (logThreadRunning && pthread_create(&logThread, NULL, log_main, NULL) != 0)
+    {
+        sem_destroy(&logWake);
+        logThreadRunning = false;
+    }
+#endif
+}
 
-    // Initialize powerups
-    for (int i = 0; i < POWERUPS_MAX; i++) powerups[i].active = false; // All powerups start inactive
+void stop_log(void)
+{
+    if (logFile == NULL) return;
+#ifndef _WIN32
+    if (logThreadRunning)
+    {
+        logThreadRunning = false;
+        sem_post(&logWake);                                 // Last drain, then the thread exits
+        pthread_join(logThread, NULL);
+        sem_destroy(&logWake);
+    }
+#endif
+    drain_log(&gameLog);
+    if (gameLog.dropped > 0) fprintf(stderr, "log: %u records dropped (writer fell behind)\n", gameLog.dropped);
+    fclose(logFile);
+    logFile = NULL;
+}
 
-    score = 0;                   // Reset score
-    pause = false;               // Unpause if previously paused
-    waiting_for_launch = true;   // Ball ready to be launched (space bar)
+static int log_spec_length(const char *f, char type)
+{
+    // Length of the conversion at f ('%' included) if the logger could have written it for an
+    // argument of this type: flags, up to two width digits, '.' and up to two precision digits,
+    // then a conversion that takes that type. Anything else (%n, *, length modifiers, %s...) would
+    // have printf read or write something other than the one argument it gets, so it's 0
+    int n = 1;
+    while (n < 6 && f[n] != '\0' && strchr("-+ #0", f[n]) != NULL) n++;
+    for (int d = 0; d < 2 && f[n] >= '0' && f[n] <= '9'; d++) n++;
+    if (f[n] == '.')
+    {
+        n++;
+        for (int d = 0; d < 2 && f[n] >= '0' && f[n] <= '9'; d++) n++;
+    }
+    const char *conversions = (type == 'i') ? "diuxXc" : (type == 'f') ? "fFeEgG" : "";
+    return (f[n] != '\0' && strchr(conversions, f[n]) != NULL) ? n + 1 : 0;
 }
 
-void spawn_powerup(Vector2 pos)
+static bool log_format_ok(const char *format, const char *types)
 {
-    t_powerup_type type = POWERUP_NONE;                 // Default powerup type
-    int r = rand() % 100;                               // Get random value 0-99
-    if (r < 40) type = POWERUP_EXPAND;
-    else if (r < 70) type = POWERUP_EXTRA_LIFE;
-    else type = POWERUP_MULTI_BALL;
-    for (int i = 0; i < POWERUPS_MAX; i++) {            // Find a slot for new powerup
-        if (!powerups[i].active) {                      // Only spawn if inactive
-            powerups[i].pos = pos;                      // Set position
-            powerups[i].spd = (Vector2){0, 2};          // Fall straight down at speed 2
-            powerups[i].type = type;                    // Set powerup type
-            powerups[i].active = true;                  // Mark as active/visible
-            break;
+    // One valid conversion per argument letter, in order, and no more
+    int arg = 0;
+    for (const char *f = format; *f != '\0'; f++)
+    {
+        if (*f != '%') continue;
+        if (f[1] == '%') { f++; continue; }
+        int n = (arg < LOG_MAX_ARGS) ? log_spec_length(f, types[arg]) : 0;
+        if (n == 0) return false;
+        f += n - 1;
+        arg++;
+    }
+    return types[arg] == '\0';
+}
+
+int decode_log(const char *path)
+{
+    // Uses the message table stored in the file, so old logs decode with any build
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) { fprintf(stderr, "log: can't open %s\n", path); return 1; }
+    uint32_t head[3];
+    if (fread(head, sizeof(head), 1, file) != 1 || memcmp(head, "ARKL", 4) != 0 || head[1] != LOG_VERSION || head[2] > 1024)
+    {
+        fprintf(stderr, "log: %s is not a version %d log\n", path, LOG_VERSION);
+        fclose(file);
+        return 1;
+    }
+    uint32_t count = head[2];
+    char (*text)[2][256] = calloc(count, sizeof(*text));
+    bool ok = true;
+    for (uint32_t m = 0; ok && m < count; m++)
+        for (int t = 0; ok && t < 2; t++)
+        {
+            uint16_t length;
+            ok = fread(&length, 2, 1, file) == 1 && length < 256 && fread(text[m][t], 1, length, file) == length;
+        }
+    for (uint32_t m = 0; ok && m < count; m++)
+        if (!log_format_ok(text[m][0], text[m][1]))
+        {
+            fprintf(stderr, "log: %s has an unsafe format for message %u: \"%s\"\n", path, m, text[m][0]);
+            ok = false;
+        }
+
+    t_log_record r;
+    while (ok && fread(&r, sizeof(r), 1, file) == 1)
+    {
+        if (r.msg >= count) { printf("%10.4f  <unknown message %u>\n", r.time, r.msg); continue; }
+        // Print the format piece by piece, one conversion at a time, with each raw argument
+        printf("%10.4f  ", r.time);
+        const char *f = text[r.msg][0], *types = text[r.msg][1];
+        int arg = 0;
+        while (*f != '\0')
+        {
+            if (*f != '%') { putchar(*f++); continue; }
+            if (f[1] == '%') { putchar('%'); f += 2; continue; }
+            char spec[16];
+            int n = log_spec_length(f, types[arg]);          // Checked against the table above
+            memcpy(spec, f, n);
+            spec[n] = '\0';
+            f += n;
+            if (arg >= r.argc) fputs(spec, stdout);
+            else if (types[arg] == 'f') { float v; memcpy(&v, &r.args[arg], 4); printf(spec, v); }
+            else if (strchr("uxX", spec[n - 1]) != NULL) printf(spec, (unsigned int)r.args[arg]);
+            else printf(spec, (int)r.args[arg]);
+            arg++;
         }
+        putchar('\n');
     }
+    free(text);
+    fclose(file);
+    return ok ? 0 : 1;
 }
 
-void apply_powerup(t_powerup_type type)
+//------------------------------------------------------------------------------------
+// Profiler - SIGPROF samples of the call stack, folded into flame graph input at exit
+//------------------------------------------------------------------------------------
+#if !defined(_WIN32) && defined(__linux__) && (defined(__x86_64__) || defined(__aarch64__))
+static void profile_signal(int sig, siginfo_t *info, void *context)
 {
-    switch (type) {
-        case POWERUP_EXPAND:                             // Expand paddle powerup
-            player.expanded = true;
-            player.expand_timer = 10.0f;                 // Lasts 10 seconds
-            player.size.x = 210;                         // Increase paddle width
-            break;
-        case POWERUP_EXTRA_LIFE:                         // Extra life powerup
-            player.life += 1;                            // Give one more life
-            break;
-        case POWERUP_MULTI_BALL:                         // Multi-ball powerup
-            for (int i = 0; i < BALLS_MAX && ballsCount < 3; i++) {
-                if (balls[i].active) {                   // For every active ball
-                    for (int j = 0; j < BALLS_MAX; j++) {
-                        if (!balls[j].active) {          // Find an inactive slot
-                            balls[j] = balls[i];         // Clone ball properties
-                            balls[j].spd.x *= -1;        // Reverse ball's X to split
-                            balls[j].spd.y *= (GetRandomValue(0, 1) == 0) ? 1 : -1; // Randomize split direction
-                            balls[j].active = true;
-                            ballsCount++;                // Increase ball count
-                            break;
-                        }
-                    }
-                }
-            }
-            break;
-        default: break;                                  // If no powerup, do nothing
+    // Async-signal-safe: reads registers, follows frame pointers within the main stack, reserves
+    // pool space with one atomic add. Needs -fno-omit-frame-pointer for more than the leaf
+    (void)sig; (void)info;
+    const ucontext_t *uc = (const ucontext_t *)context;
+#if defined(__x86_64__)
+    uintptr_t pc = (uintptr_t)uc->uc_mcontext.gregs[REG_RIP];
+    uintptr_t fp = (uintptr_t)uc->uc_mcontext.gregs[REG_RBP];
+    uintptr_t sp = (uintptr_t)uc->uc_mcontext.gregs[REG_RSP];
+#else
+    uintptr_t pc = (uintptr_t)uc->uc_mcontext.pc;
+    uintptr_t fp = (uintptr_t)uc->uc_mcontext.regs[29];
+    uintptr_t sp = (uintptr_t)uc->uc_mcontext.sp;
+#endif
+    uintptr_t stack[PROFILE_DEPTH];
+    unsigned int depth = 0;
+    stack[depth++] = pc + 1;                                 // +1: every entry is "just after", like return addresses
+    bool mainStack = sp < profileStackTop && profileStackTop - sp < (8u << 20); // Other threads: leaf only
+    while (mainStack && depth < PROFILE_DEPTH && fp >= sp && fp < profileStackTop && (fp & (sizeof(uintptr_t) - 1)) == 0)
+    {
+        const uintptr_t *frame = (const uintptr_t *)fp;
+        if (frame[1] == 0) break;
+        stack[depth++] = frame[1];                           // Return address
+        if (frame[0] <= fp) break;                           // Stack grows down; anything else is junk
+        fp = frame[0];
     }
+
+    unsigned int at = ATOMIC_ADD(&profileUsed, depth + 1);
+    if (at + depth + 1 > PROFILE_POOL) { ATOMIC_ADD(&profileDropped, 1); return; }
+    profilePool[at] = depth;
+    memcpy(&profilePool[at + 1], stack, depth*sizeof(uintptr_t));
 }
 
-void reset_balls(Vector2 pos)
+static void profile_symbol(uintptr_t address, char *out, int size)
 {
-    for (int i = 0; i < BALLS_MAX; i++) balls[i].active = false; // Deactivate all balls
-    ballsCount = 1;                      // Only have one ball after reset
-    balls[0].radius = 12;                // Standard size
-    balls[0].pos = pos;                  // Place at given position
-    balls[0].spd = (Vector2){ 0, 0 };    // Ball at rest
-    balls[0].active = false;             // Wait for launch
+    // Named when the symbol is visible to dladdr (link with -rdynamic), else module+offset for addr2line
+    Dl_info info;
+    if (dladdr((void *)(address - 1), &info) == 0 || info.dli_fname == NULL) { snprintf(out, size, "0x%lx", (unsigned long)address); return; }
+    if (info.dli_sname != NULL) { snprintf(out, size, "%s", info.dli_sname); return; }
+    const char *module = strrchr(info.dli_fname, '/');
+    snprintf(out, size, "%s+0x%lx", (module != NULL) ? module + 1 : info.dli_fname,
+             (unsigned long)(address - 1 - (uintptr_t)info.dli_fbase));
+}
+
+static int compare_lines(const void *a, const void *b)
+{
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+void start_profiler(void *stackTop)
+{
+    if (profilePath == NULL || profileHz <= 0) return;
+    profilePool = calloc(PROFILE_POOL, sizeof(uintptr_t));  // Up front: nothing may allocate in the handler
+    if (profilePool == NULL) return;
+    profileStackTop = (uintptr_t)stackTop + 4096;           // main()'s frame, plus what libc put above it
+
+    struct sigaction action = { 0 };
+    action.sa_sigaction = profile_signal;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGPROF, &action, NULL);
+
+    struct itimerval timer = { { 0, 1000000/profileHz }, { 0, 1000000/profileHz } };
+    setitimer(ITIMER_PROF, &timer, NULL);                   // Ticks on CPU time, so idle waits aren't sampled
+    atexit(stop_profiler);
+}
+
+void stop_profiler(void)
+{
+    if (profilePool == NULL) return;
+    struct itimerval off = { { 0, 0 }, { 0, 0 } };
+    setitimer(ITIMER_PROF, &off, NULL);
+    signal(SIGPROF, SIG_IGN);
+
+    // One "root;...;leaf" line per sample, then identical lines are counted
+    unsigned int used = (profileUsed < PROFILE_POOL) ? profileUsed : PROFILE_POOL;
+    int samples = 0;
+    for (unsigned int at = 0; at < used && profilePool[at] > 0 && at + 1 + profilePool[at] <= used; at += 1 + profilePool[at]) samples++;
+    char **lines = malloc(samples*sizeof(char *));
+    char frame[256];
+    unsigned int at = 0;
+    for (int n = 0; n < samples; n++, at += 1 + profilePool[at])
+    {
+        unsigned int depth = (unsigned int)profilePool[at];
+        size_t cap = depth*sizeof(frame), length = 0;
+        lines[n] = malloc(cap);
+        lines[n][0] = '\0';
+        for (unsigned int d = depth; d-- > 0; )
+        {
+            profile_symbol(profilePool[at + 1 + d], frame, sizeof(frame));
+            length += snprintf(lines[n] + length, cap - length, "%s%s", frame, (d > 0) ? ";" : "");
+        }
+    }
+    qsort(lines, samples, sizeof(char *), compare_lines);
+
+    FILE *file = fopen(profilePath, "w");
+    if (file == NULL) fprintf(stderr, "profile: can't write %s\n", profilePath);
+    for (int n = 0, count = 1; file != NULL && n < samples; n++, count++)
+        if (n + 1 == samples || strcmp(lines[n], lines[n + 1]) != 0) { fprintf(file, "%s %d\n", lines[n], count); count = 0; }
+    if (file != NULL) fclose(file);
+    if (profileDropped > 0) fprintf(stderr, "profile: %u samples dropped (pool full)\n", profileDropped);
+
+    for (int n = 0; n < samples; n++) free(lines[n]);
+    free(lines);
+    free(profilePool);
+    profilePool = NULL;
+}
+#else
+void start_profiler(void *stackTop)
+{
+    (void)stackTop;
+    if (profilePath != NULL) fprintf(stderr, "profile: not supported on this platform\n");
 }
 
+void stop_profiler(void) { }
+#endif
+
+#endif // ARKANOID_CORE
+
 void update_game(void)
 {
+#ifndef ARKANOID_CORE
+    if (rewindSnaps != NULL) memset(&rewindView, 0, sizeof(rewindView));   // The overlay shows this tick only
+#endif
     if (gameState == GAME_TITLE)
     {
-        if (IsKeyPressed(KEY_SPACE) || IsKeyPressed(KEY_ENTER))
+        prepare_level_async();           // Use idle title ticks to get the next game ready
+
+        if (input_pressed(INPUT_LAUNCH) || input_pressed(INPUT_CONFIRM))
         {
+#ifdef ARKANOID_CORE
+            gameSeed = rngState;         // Core: no rand(), carry on from the last game's RNG
+#else
+            gameSeed = (uint32_t)rand(); // Fresh seed per game (recorded in the replay)
+#endif
             init_game();                 // Start new game on space/enter
             gameState = GAME_PLAYING;    // Switch to gameplay
+            log_msg(LOG_GAME_START, gameSeed, bricksLeft);
         }
     }
     else if (gameState == GAME_PLAYING)
     {
-        if (IsKeyPressed(KEY_P)) pause = !pause;     // Toggle pause with P key
+        if (input_pressed(INPUT_PAUSE)) paused = !paused;   // Toggle pause with P key
 
-        if (!pause)                                 // Updates only if not paused
+        if (!paused)                                // Updates only if not paused
         {
             // -------- Player movement (left/right arrow keys) --------
-            if (IsKeyDown(KEY_LEFT)) player.pos.x -= player.speed;
-            if (IsKeyDown(KEY_RIGHT)) player.pos.x += player.speed;
+            if (input_down(INPUT_LEFT)) player.pos.x -= player.speed;
+            if (input_down(INPUT_RIGHT)) player.pos.x += player.speed;
             if (player.pos.x < 0) player.pos.x = 0;  // Prevent going off left edge
             if (player.pos.x + player.size.x > screenWidth) player.pos.x = screenWidth - player.size.x; // Prevent right edge
 
             // -------- Shrink paddle if "expand" timer runs out --------
             if (player.expanded) {
-                player.expand_timer -= GetFrameTime();      // Subtract elapsed frame time
+                player.expand_timer -= TICK_DT;             // Subtract one tick of time
                 if (player.expand_timer <= 0.0f) {
                     player.expanded = false;                // Effect over
                     player.size.x = 140;                    // Reset paddle size
@@ -263,17 +4693,23 @@ void update_game(void)
             {
                 balls[0].pos.x = player.pos.x + player.size.x/2;
                 balls[0].pos.y = player.pos.y - balls[0].radius - 2;
-                if (IsKeyPressed(KEY_SPACE))
+                if (input_pressed(INPUT_LAUNCH))
                 {
                     balls[0].active = true;                        // Set moving
                     balls[0].spd = (Vector2){
-                        6 * ((GetRandomValue(0, 1) == 0) ? -1 : 1), // Speed x: left/right ranm
+                        6 * ((game_random(0, 1) == 0) ? -1 : 1), // Speed x: left/right ranm
                         -6 };                                       // Speed y: always up at start
                     waiting_for_launch = false;
+                    log_msg(LOG_LAUNCH, balls[0].spd.x);
                 }
             }
 
             // -------- Ball logic for all balls (movement, collisions, etc) --------
+            // Brick hits are found for every ball first and only applied afterwards, so each ball
+            // sees the bricks as they were at the start of the tick no matter what order balls run in
+            t_contact contacts[BALLS_MAX][BALL_CONTACTS_MAX];       // Bricks each ball touches this tick
+            int contactsCount[BALLS_MAX] = { 0 };
+
             for (int b = 0; b < BALLS_MAX; b++)
             {
                 if (!balls[b].active) continue;                     // Only process active balls
@@ -295,6 +4731,12 @@ void update_game(void)
                     balls[b].spd.y *= -1;                                 // Bounce ball away
                     float hitPos = (balls[b].pos.x - (player.pos.x + player.size.x/2)) / (player.size.x/2);
                     balls[b].spd.x = 6 * hitPos;                          // Adjust angle based on hit position
+                    play_sound(SOUND_PADDLE, 0.6f);
+                    flight_event(FLIGHT_PADDLE, b);
+#ifndef ARKANOID_CORE
+                    rewindView.paddleHits |= 1u << b;
+#endif
+                    log_msg(LOG_PADDLE_HIT, b, hitPos);
                 }
 
                 // ----- Ball missed (falls below screen) -----
@@ -302,26 +4744,60 @@ void update_game(void)
                 {
                     balls[b].active = false;                              // Remove ball
                     ballsCount--;
+                    continue;                                             // Can't hit bricks from down there
+                }
+
+                // ----- Find brick contacts (read-only, independent per ball) -----
+                contactsCount[b] = find_brick_contacts(balls[b].pos, balls[b].radius, contacts[b], BALL_CONTACTS_MAX);
+            }
+
+#ifndef ARKANOID_CORE
+            if (rewindSnaps != NULL)                                   // For the rewind debugger's overlay
+            {
+                memcpy(rewindView.contacts, contacts, sizeof(contacts));
+                memcpy(rewindView.contactsCount, contactsCount, sizeof(contactsCount));
+            }
+#endif
+
+            // ----- Resolve brick contacts -----
+            // Balls claim bricks in index order: the first ball to reach a brick destroys it and
+            // scores, any other ball that hit the same brick this tick only bounces off it.
+            // All of a ball's contacts are combined into one normal and it reflects once, so two
+            // bricks hit side by side don't cancel each other out, and side hits bounce sideways
+            for (int b = 0; b < BALLS_MAX; b++)
+            {
+                if (contactsCount[b] == 0) continue;
+
+                Vector2 n = { 0, 0 };
+                for (int c = 0; c < contactsCount[b]; c++)
+                {
+                    int i = contacts[b][c].brick;
+                    n.x += contacts[b][c].normal.x;
+                    n.y += contacts[b][c].normal.y;
+                    if (!brick_alive(i)) continue;                        // Already claimed by a lower ball
+
+                    destroy_brick(i);                                     // Destroy brick
+                    score += 100;                                         // Add score
+                    play_sound(SOUND_BRICK, 0.5f);
+                    flight_event(FLIGHT_BRICK, i);
+                    log_msg(LOG_BRICK, b, i, bricks[i].rect.x, bricks[i].rect.y, score);
+                    if (game_random(1,100) <= 22)                      // ~22% chance to spawn powerup
+                        spawn_powerup((Vector2){                          // From the brick's center
+                            bricks[i].rect.x + bricks[i].rect.width/2,
+                            bricks[i].rect.y + bricks[i].rect.height/2
+                        });
                 }
 
-                // ----- Collision with bricks -----
-                for (int y = 0; y < LINES_OF_BRICKS; y++)
+                // Mirror the velocity about the combined normal, only if moving into the bricks
+                float len = sqrtf(n.x*n.x + n.y*n.y);
+                if (len < 0.001f) continue;                               // Hits from opposite sides cancel out
+                n.x /= len;
+                n.y /= len;
+                float vn = balls[b].spd.x*n.x + balls[b].spd.y*n.y;
+                if (vn < 0.0f)
                 {
-                    for (int x = 0; x < BRICKS_PER_LINE; x++)
-                    {
-                        if (bricks[y][x].active &&
-                            CheckCollisionCircleRec(balls[b].pos, balls[b].radius, bricks[y][x].rect))
-                        {
-                            bricks[y][x].active = false;                  // Destroy brick
-                            balls[b].spd.y *= -1;                         // Bounce ball
-                            score += 100;                                 // Add score
-                            if (GetRandomValue(1,100) <= 22)              // ~22% chance to spawn powerup
-                                spawn_powerup((Vector2){
-                                    bricks[y][x].rect.x + brickSize.x/2,
-                                    bricks[y][x].rect.y + brickSize.y/2
-                                });
-                        }
-                    }
+                    balls[b].spd.x -= 2*vn*n.x;                           // Bounce ball
+                    balls[b].spd.y -= 2*vn*n.y;
                 }
             }
 
@@ -333,6 +4809,9 @@ void update_game(void)
             if (!anyBallActive && !waiting_for_launch)
             {
                 player.life--;
+                play_sound(SOUND_BALL_LOST, 0.7f);
+                flight_event(FLIGHT_BALL_LOST, player.life);
+                log_msg(LOG_BALL_LOST, player.life);
                 if (player.life <= 0)
                     gameState = GAME_OVER;                             // End game
                 else {
@@ -356,44 +4835,35 @@ void update_game(void)
                 if (CheckCollisionRecs(paddleRect, puRect))
                 {
                     apply_powerup(powerups[i].type);                    // Apply effect
+                    play_sound(SOUND_POWERUP, 0.6f);
+                    flight_event(FLIGHT_POWERUP, powerups[i].type);
+                    log_msg(LOG_POWERUP, powerups[i].type);
                     powerups[i].active = false;
                 }
                 if (powerups[i].pos.y > screenHeight) powerups[i].active = false; // Offscreen cleanup
             }
 
             // -------- Check win condition (no bricks left) --------
-            bool bricksLeft = false;
-            for (int y = 0; y < LINES_OF_BRICKS; y++)
-                for (int x = 0; x < BRICKS_PER_LINE; x++)
-                    if (bricks[y][x].active) bricksLeft = true;
-            if (!bricksLeft) gameState = GAME_WIN;
+            if (bricksLeft == 0) gameState = GAME_WIN;
         }
     }
     else
     {
-        if (IsKeyPressed(KEY_ENTER) || IsKeyPressed(KEY_SPACE))
+        if (input_pressed(INPUT_CONFIRM) || input_pressed(INPUT_LAUNCH))
         {
             gameState = GAME_TITLE;                        // Return to title on key
         }
     }
 }
 
+#ifndef ARKANOID_CORE
 void draw_background(void)
 {
-    // Vertical gradient background fill
-    for (int i = 0; i < screenHeight; i += 4)
-    {
-        float t = (float)i / screenHeight;
-        Color top = (Color){ 40, 40, 90, 255 };
-        Color bot = (Color){ 130, 130, 220, 255 };
-        Color mid = (Color){
-            (int)(top.r * (1-t) + bot.r * t),
-            (int)(top.g * (1-t) + bot.g * t),
-            (int)(top.b * (1-t) + bot.b * t),
-            255
-        };
-        DrawRectangle(0, i, screenWidth, 4, mid);              // 4-pixel-thick horizontal stripe
-    }
+    // Vertical gradient background fill, baked by load_assets()
+    // (render textures are stored upside down, hence the negative source height)
+    DrawTextureRec(backgroundTex.texture,
+        (Rectangle){ 0, 0, (float)backgroundTex.texture.width, (float)-backgroundTex.texture.height },
+        (Vector2){ 0, 0 }, WHITE);
 }
 
 void draw_powerup_icon(t_powerup_type type, Vector2 pos)
@@ -419,55 +4889,85 @@ void draw_powerup_icon(t_powerup_type type, Vector2 pos)
     }
 }
 
-void draw_title_screen(void)
-{
-    draw_background();                                     // Fill window with background gradient
-
-    // Draw "Arkanoid" as main title
-    int arkanoidFontSize = 110;                            // Size for main title text
-    int arkanoidWidth = MeasureText("Arkanoid", arkanoidFontSize);
-    DrawText("Arkanoid",
-        screenWidth/2 - arkanoidWidth/2,                   // Center horizontally
-        120,                                               // Y position for title
-        arkanoidFontSize,
-        (Color){ 255, 180, 60, 255 });
-         
-
-    // Creater info at bottom right
-    const char *versionStr = "Made by --> Yash Shah";
-    int versionW = MeasureText(versionStr, 28);
-    DrawText(versionStr, screenWidth - versionW - 24, screenHeight - 44, 28, LIGHTGRAY);
-
-    // Control and powerup instructions below title
-    const char *instructions[] = {
-        "Press SPACE or ENTER to start",
-        "Move paddle: LEFT / RIGHT arrow keys",
-        "Launch ball: SPACE",
-        "Pause/Resume: P",
-        "Clear all bricks to win!",
-        "",
-        "Powerups:",
-        "   E = Expand Paddle,   + = Extra Life,   Three Balls = Multi-ball"
-    };
-    int instrStartY = 290;
-    for (int i = 0; i < 8; i++) {
-        int instrW = MeasureText(instructions[i], 26);
-        DrawText(instructions[i],
-            screenWidth/2 - instrW/2,
-            instrStartY + i*32,
-            26, RAYWHITE);
+const t_layout *get_layout(int width, int height)
+{
+    // Text is laid out in pixels at the target size (not scaled as a picture) so it stays sharp;
+    // the MeasureText() calls that needs happen only when a new size shows up
+    for (int i = 0; i < LAYOUT_CACHE; i++)
+        if (layouts[i].width == width && layouts[i].height == height) return &layouts[i];
+
+    t_layout *l = &layouts[layoutNext];
+    layoutNext = (layoutNext + 1) % LAYOUT_CACHE;
+    l->width = width;
+    l->height = height;
+    l->scale = fminf((float)width/screenWidth, (float)height/screenHeight);
+    l->view = (Vector2){ (width - screenWidth*l->scale)/2, (height - screenHeight*l->scale)/2 };
+    for (int t = 0; t < TEXT_COUNT; t++)
+    {
+        const t_text_spec *spec = &textSpecs[t];
+        int size = (int)(spec->size*l->scale + 0.5f);
+        int textW = (sdfFont.texture.id > 0) ? (int)MeasureTextEx(sdfFont, spec->text, (float)size, size/10.0f).x
+                                             : MeasureText(spec->text, size);
+        float x = (spec->align == ALIGN_LEFT) ? spec->x*l->scale :
+                  (spec->align == ALIGN_CENTER) ? (screenWidth/2 + spec->x)*l->scale - textW/2 :
+                  (screenWidth - spec->x)*l->scale - textW;
+        l->textPos[t] = (Vector2){ l->view.x + x, l->view.y + spec->y*l->scale };
+        l->textSize[t] = size;
     }
+    return l;
 }
 
-void draw_game(void)
+static void draw_text_item(const t_layout *l, Vector2 origin, t_text_item t, const char *text)
 {
-    draw_background();    // Draw background for all states
-
-    if (gameState == GAME_TITLE)
+    // text: NULL for the spec's own text, else what to show in its place (numbers filled in)
+    if (text == NULL) text = textSpecs[t].text;
+    Vector2 pos = { origin.x + l->textPos[t].x, origin.y + l->textPos[t].y };
+    int length = (int)strlen(text);
+    if (sdfFont.texture.id == 0 || textQueued == TEXT_QUEUE_MAX || textCharsUsed + length + 1 > TEXT_CHARS_MAX)
     {
-        draw_title_screen();
+        DrawText(text, (int)pos.x, (int)pos.y, l->textSize[t], textSpecs[t].color); // No SDF font (or queue full)
+        return;
     }
-    else if (gameState == GAME_PLAYING)
+    textQueue[textQueued++] = (t_text_draw){ textCharsUsed, pos, (float)l->textSize[t], textSpecs[t].color };
+    memcpy(textChars + textCharsUsed, text, length + 1);
+    textCharsUsed += length + 1;
+}
+
+void flush_text(void)
+{
+    // One shader switch and one texture for every string this frame, so they batch into one draw
+    if (textQueued == 0) return;
+    BeginShaderMode(sdfShader);
+    for (int i = 0; i < textQueued; i++)
+        DrawTextEx(sdfFont, textChars + textQueue[i].offset, textQueue[i].pos, textQueue[i].size,
+                   textQueue[i].size/10.0f, textQueue[i].color);
+    EndShaderMode();
+    textQueued = 0;
+    textCharsUsed = 0;
+}
+
+void draw_title_screen(const t_layout *l, Vector2 origin)
+{
+    // Background already drawn by draw_game()
+    draw_text_item(l, origin, TEXT_TITLE, NULL);             // "Arkanoid" as main title
+    draw_text_item(l, origin, TEXT_CREDIT, NULL);            // Creator info at bottom right
+    for (int t = TEXT_HELP_FIRST; t <= TEXT_HELP_LAST; t++)  // Control and powerup instructions below title
+        draw_text_item(l, origin, t, NULL);
+}
+
+void draw_game(Rectangle target)
+{
+    // Shapes are drawn in playfield units through a scale matrix (crisp at any size, and still
+    // one batch); text is drawn afterwards at pixel sizes from the cached layout
+    const t_layout *l = get_layout((int)target.width, (int)target.height);
+    Vector2 origin = { target.x, target.y };
+    rlPushMatrix();
+    rlTranslatef(origin.x + l->view.x, origin.y + l->view.y, 0.0f);
+    rlScalef(l->scale, l->scale, 1.0f);
+
+    draw_background();    // Draw background for all states
+
+    if (gameState == GAME_PLAYING)
     {
         // Draw paddle (expanded color if effect active)
         DrawRectangleV(player.pos, player.size, player.expanded ? YELLOW : DARKBLUE);
@@ -481,43 +4981,101 @@ void draw_game(void)
                 DrawCircleV(balls[b].pos, balls[b].radius, RED);
 
         // Draw bricks
-        for (int y = 0; y < LINES_OF_BRICKS; y++)
-            for (int x = 0; x < BRICKS_PER_LINE; x++)
-                if (bricks[y][x].active)
-                    DrawRectangleRec(bricks[y][x].rect, (y + x) % 2 ? GRAY : ORANGE);
+        for (int w = 0; w*64 < bricksCount; w++)
+        {
+            uint64_t alive = bricksAlive[w];
+            if (alive == 0) continue;                               // 64 cleared bricks, nothing to draw
+            for (int k = 0; k < 64; k++)
+                if ((alive >> k) & 1)
+                {
+                    const t_brick *brick = &bricks[w*64 + k];
+                    if (brick->poly < 0) DrawRectangleRec(brick->rect, brick->color);
+                    else DrawTriangleFan(brickPolys[brick->poly].v, brickPolys[brick->poly].count, brick->color);
+                }
+        }
 
         // Draw powerups
         for (int i = 0; i < POWERUPS_MAX; i++)
             if (powerups[i].active)
                 draw_powerup_icon(powerups[i].type, powerups[i].pos);
 
-        // Draw score at top right
-        DrawText(TextFormat("SCORE: %04i", score), screenWidth - 170, 20, 28, YELLOW);
+        if (rewindFrozen) draw_rewind_overlay();
+    }
+    rlPopMatrix();
 
-        // Draw "PAUSED" overlay
-        if (pause)
-            DrawText("GAME PAUSED", screenWidth/2 - MeasureText("GAME PAUSED", 48)/2, screenHeight/2 - 48, 48, GRAY);
+    if (gameState == GAME_TITLE)
+    {
+        draw_title_screen(l, origin);
+    }
+    else if (gameState == GAME_PLAYING)
+    {
+        draw_text_item(l, origin, TEXT_SCORE, TextFormat(textSpecs[TEXT_SCORE].text, score)); // Score at top right
+        if (autopilotOn && !attractOn) draw_text_item(l, origin, TEXT_AUTOPILOT, NULL);
+        if (attractOn) draw_text_item(l, origin, TEXT_DEMO, NULL);
+        if (paused) draw_text_item(l, origin, TEXT_PAUSED, NULL);          // "PAUSED" overlay
     }
     else if (gameState == GAME_OVER)
     {
-        DrawText("GAME OVER", screenWidth/2 - MeasureText("GAME OVER", 56)/2, screenHeight/2 - 80, 56, RED);
-        DrawText(TextFormat("FINAL SCORE: %i", score), screenWidth/2-MeasureText("FINAL SCORE: 0000", 32)/2, screenHeight/2, 32, MAROON);
-        DrawText("PRESS [ENTER] TO RETURN TO TITLE", screenWidth/2-MeasureText("PRESS [ENTER] TO RETURN TO TITLE", 26)/2, screenHeight/2 + 72, 26, DARKGRAY);
+        draw_text_item(l, origin, TEXT_OVER, NULL);
+        draw_text_item(l, origin, TEXT_OVER_SCORE, TextFormat("FINAL SCORE: %i", score));
+        draw_text_item(l, origin, TEXT_OVER_HINT, NULL);
     }
     else if (gameState == GAME_WIN)
     {
-        DrawText("VICTORY!", screenWidth/2 - MeasureText("VICTORY!", 64)/2, screenHeight/2 - 96, 64, YELLOW);
-        DrawText(TextFormat("FINAL SCORE: %i", score), screenWidth/2-MeasureText("FINAL SCORE: 0000", 34)/2, screenHeight/2, 34, MAROON);
-        DrawText("YOU CLEARED ALL THE BRICKS!", screenWidth/2-MeasureText("YOU CLEARED ALL THE BRICKS!", 28)/2, screenHeight/2 + 48, 28, ORANGE);
-        DrawText("PRESS [ENTER] TO RETURN TO TITLE", screenWidth/2-MeasureText("PRESS [ENTER] TO RETURN TO TITLE", 26)/2, screenHeight/2 + 96, 26, DARKGRAY);
+        draw_text_item(l, origin, TEXT_WIN, NULL);
+        draw_text_item(l, origin, TEXT_WIN_SCORE, TextFormat("FINAL SCORE: %i", score));
+        draw_text_item(l, origin, TEXT_WIN_CLEARED, NULL);
+        draw_text_item(l, origin, TEXT_WIN_HINT, NULL);
+    }
+    if (rewindFrozen)
+    {
+        draw_text_item(l, origin, TEXT_REWIND, TextFormat("REWIND  TICK %i / %i", rewindTick, rewindLatest));
+        draw_text_item(l, origin, TEXT_REWIND_HINT, NULL);
     }
 }
 
-
 void update_draw_frame(void)
 {
-    update_game();   // Step logic for one frame
+    // Step logic in fixed ticks until it catches up with real time; each tick only sees
+    // the input events sampled before its end, so a tap lands on the tick it happened in
+    double now = GetTime();
+    int ticks = 0;
+    update_rewind();                                   // Only with --rewind
+    while (!rewindFrozen && simTime + TICK_DT <= now && ticks < MAX_TICKS_PER_FRAME)
+    {
+        simTime += TICK_DT;
+        consume_input(simTime);
+        update_attract();
+        toggle_autopilot();
+        apply_autopilot();
+        double tickStart = GetTime();
+        step_game();
+        publish_tick(GetTime() - tickStart);
+        render_audio_tick();
+        ticks++;
+    }
+    if (ticks == MAX_TICKS_PER_FRAME || rewindFrozen) simTime = now;   // Too far behind (window dragged, etc.), drop the backlog
+    publish_metrics(now - lastFrameTime);
+    lastFrameTime = now;
+    double updated = GetTime();
+
     BeginDrawing();  // Begin rendering
-    draw_game();     // Draw everything for one frame
+    ClearBackground(BLACK);                                          // Letterbox bars when the window isn't 4:3
+    draw_game((Rectangle){ 0, 0, (float)GetScreenWidth(), (float)GetScreenHeight() }); // Draw everything for one frame
+    flush_text();                                                    // Then all of its text at once
+    update_tty(now);                                                 // Terminal copy, when --tty is on
+    double drawn = GetTime();
     EndDrawing();    // End rendering
+    if (startupTime[STARTUP_FIRST_FRAME] == 0.0) startup_mark(STARTUP_FIRST_FRAME);
+    double presented = GetTime();
+    wait_for_next_frame();
+
+    if (flightDir != NULL)
+    {
+        float ms[4] = { (float)((updated - now)*1e3), (float)((drawn - updated)*1e3),
+                        (float)((presented - drawn)*1e3), (float)((GetTime() - presented)*1e3) };
+        flight_frame(now, ms);
+    }
+    flush_log();
 }
+#endif // ARKANOID_CORE
@@ -0,0 +1,82 @@
+/*******************************************************************************************
+
+                                    Arkanoid core test
+
+    Builds the simulation core the way firmware does (Arkanoid.c included with ARKANOID_CORE
+    defined) and checks on the build machine what a port to a controller depends on: the state
+    fits CORE_STATE_BUDGET, the same seed and input play the same game, and update_game() runs
+    fast enough. `make core-test` builds and runs it; see "Simulation core" in the README.
+
+********************************************************************************************/
+
+#include <stdio.h>                   // Host side only: the core itself uses none of these
+#include <stdlib.h>
+#include <time.h>
+
+#define ARKANOID_CORE
+#include "Arkanoid.c"
+
+#define CORE_TEST_GAMES      200                  // Seeded games timed for the ticks/s figure
+#define CORE_TEST_MAX_TICKS  (TICK_RATE*60*10)    // Ten minutes of play per game at most
+#define CORE_TEST_MIN_RATE   (TICK_RATE*1000.0)   // Ticks/s the host must reach (argv[1] overrides)
+
+static void follow_ball(void)
+{
+    // Keys for one tick: paddle under the lowest ball, launch whenever one is waiting
+    int lowest = 0;
+    for (int b = 0; b < BALLS_MAX; b++)
+        if (balls[b].active && (!balls[lowest].active || balls[b].pos.y > balls[lowest].pos.y)) lowest = b;
+    float d = balls[lowest].pos.x - (player.pos.x + player.size.x/2);
+    input.down = (d < -6.0f) << INPUT_LEFT | (d > 6.0f) << INPUT_RIGHT;
+    input.pressed = 1u << INPUT_LAUNCH;
+}
+
+static uint32_t play_game(uint32_t seed, long long *ticks)
+{
+    // Returns a fingerprint of how the game ended, to compare runs with
+    gameSeed = seed;
+    init_game();
+    gameState = GAME_PLAYING;
+    for (int t = 0; t < CORE_TEST_MAX_TICKS && gameState == GAME_PLAYING; t++)
+    {
+        follow_ball();
+        update_game();
+        (*ticks)++;
+    }
+    uint32_t paddle;
+    memcpy(&paddle, &player.pos.x, 4);
+    return (uint32_t)score*2654435761u ^ (uint32_t)bricksLeft << 16 ^ (uint32_t)gameState ^ paddle ^ rngState;
+}
+
+int main(int argc, char **argv)
+{
+    double minRate = (argc > 1) ? atof(argv[1]) : CORE_TEST_MIN_RATE;
+    int failures = 0;
+
+    // The build already fails over budget; this reports the figure and guards against the check going away
+    printf("core: state %u of %u bytes\n", (unsigned int)coreStateSize, (unsigned int)CORE_STATE_BUDGET);
+    if (coreStateSize > CORE_STATE_BUDGET) { printf("core: FAIL state over budget\n"); failures++; }
+
+    long long ticks = 0;
+    uint32_t first = play_game(7, &ticks), second = play_game(7, &ticks);
+    if (first != second) { printf("core: FAIL seed 7 played two different games\n"); failures++; }
+
+    ticks = 0;
+    long long totalScore = 0;
+    int wins = 0;
+    clock_t start = clock();
+    for (int g = 0; g < CORE_TEST_GAMES; g++)
+    {
+        play_game((uint32_t)g + 1, &ticks);
+        totalScore += score;
+        wins += (gameState == GAME_WIN);
+    }
+    double seconds = (double)(clock() - start)/CLOCKS_PER_SEC;
+    double rate = (seconds > 0.0) ? ticks/seconds : 0.0;
+    printf("core: %d games, mean score %.1f, %d wins, %lld ticks\n", CORE_TEST_GAMES, (double)totalScore/CORE_TEST_GAMES, wins, ticks);
+    printf("core: %.0f ticks/s (%.3f us/tick, %.0fx real time)\n", rate, (rate > 0.0) ? 1e6/rate : 0.0, rate/TICK_RATE);
+    if (rate < minRate) { printf("core: FAIL slower than %.0f ticks/s\n", minRate); failures++; }
+
+    printf("core: %s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}